@@ -1,7 +1,9 @@
 TEMPLATE = subdirs
 SUBDIRS = src/lib \
           src/pluginpy \
-          src
+          src \
+          src/bench \
+          src/tests
 
 
 win32 {
@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "Verby.h"
 #include "gui.h"
 #include "PluginMsg.h"
+#include "SubsequenceMatch.h"
 
 using namespace launchy;
 
@@ -77,17 +78,16 @@ const QString& Verby::getIconPath() const {
 }
 
 bool Verby::isMatch(const QString& text1, const QString& text2) {
-    int text2Length = text2.count();
-    int curChar = 0;
-    foreach(QChar c, text1) {
-        if (c.toLower() == text2[curChar].toLower()) {
-            ++curChar;
-            if (curChar >= text2Length) {
-                return true;
-            }
-        }
+    // Lower each character on its own, QString::toLower may change the length
+    QString lower1(text1.size(), Qt::Uninitialized);
+    for (int i = 0; i < text1.size(); ++i) {
+        lower1[i] = text1[i].toLower();
+    }
+    QString lower2(text2.size(), Qt::Uninitialized);
+    for (int i = 0; i < text2.size(); ++i) {
+        lower2[i] = text2[i].toLower();
     }
-    return false;
+    return isSubsequence(lower1, lower2);
 }
 
 void Verby::addCatItem(QString text, QList<CatItem>* results,
@@ -92,6 +92,10 @@ void AppBase::alterItem(CatItem* item) {
     Q_UNUSED(item)
 }
 
+void AppBase::beginAlterItems() {
+
+}
+
 bool AppBase::supportsAlphaBorder() const {
     return false;
 }
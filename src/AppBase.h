@@ -47,6 +47,8 @@ public:
 
     // Need to alter an indexed item?  e.g. .desktop files
     virtual void alterItem(CatItem* item);
+    // Called before the items of a catalog update are altered
+    virtual void beginAlterItems();
     virtual QHash<QString, QList<QString>> getDirectories() = 0;
     virtual QString expandEnvironmentVars(QString txt) = 0;
 
@@ -19,22 +19,352 @@
 
 #include "Precompiled.h"
 #include "Catalog.h"
+#include <algorithm>
+#include <iterator>
+#include <queue>
+#include <tuple>
+#include <vector>
+#include <QtConcurrent>
+#include "CatalogFile.h"
 #include "GlobalVar.h"
 #include "OptionItem.h"
+#include "SubsequenceMatch.h"
 
 namespace launchy {
 
+// Number of journaled usage changes that starts a background save
+static const int JOURNAL_SAVE_COUNT = 256;
+
+// Items published by the first batch of a load, every later batch is twice as big
+// so the generations copied and the indexes rebuilt add up to twice the catalog
+static const int LOAD_BATCH_SIZE = 2000;
+
+// Evicting to this percentage of the memory budget leaves room for the
+// items added until the next commit, so not every commit has to evict
+static const int BUDGET_EVICT_PERCENT = 90;
+
+// Search names shorter than this are in the length index, longer
+// search texts are rarely typed and do not stop searches early
+static const int LENGTH_INDEX_SIZE = 32;
+
+// The part of a search handled by one thread
+struct CatalogSearchShard {
+    CatalogSearchShard()
+        : begin(0),
+          end(0),
+          complete(true) {
+    }
+
+    // Range of the search domain checked by this shard
+    int begin;
+    int end;
+    QVector<int> matched;
+    // The best ranked matched slots in rank order
+    QVector<int> top;
+    // Cleared when the shard stopped before the end of its range,
+    // matched then only holds the slots checked so far
+    bool complete;
+};
+
 Catalog::Catalog()
-    : m_timestamp(0) {
+    : m_timestamp(0),
+      m_current(std::make_shared<CatalogGeneration>()),
+      m_usage(std::make_shared<CatalogUsageMap>()),
+      m_savePending(false),
+      m_lastId(0),
+      m_loading(false),
+      m_loadExpected(false),
+      m_loaded(false),
+      m_coldSerial(0),
+      m_coldSearches(0),
+      m_coldHits(0) {
 
 }
 
 Catalog::~Catalog() {
-
+    waitForSave();
 }
 
 // Load the catalog from the specified filename
 bool Catalog::load(const QString& filename) {
+    // Usage changed after the catalog was last saved, changes made while
+    // loading are applied as they happen and have to be left out
+    QVector<UsageJournalRecord> rotated;
+    QVector<UsageJournalRecord> records;
+    quint32 fingerprint = 0;
+    bool frecencyCovered = false;
+    {
+        QMutexLocker locker(&m_usageMutex);
+        m_filename = filename;
+        if (!m_journalFilename.isEmpty()) {
+            UsageJournal::read(m_journalFilename, rotated, records);
+            fingerprint = UsageJournal::fingerprint(rotated);
+        }
+        // The launch history has to be there to score the loaded items
+        if (!m_frecencyFilename.isEmpty() && m_frecency.load(m_frecencyFilename)) {
+            frecencyCovered = !rotated.isEmpty() && m_frecency.journalFingerprint() == fingerprint;
+        }
+    }
+
+    // Cold segments are only valid while Launchy runs, remove the files
+    // left behind when it last exited without removing them
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_coldSerial == 0) {
+            QFileInfo info(filename);
+            QDir dir = info.absoluteDir();
+            foreach(const QString& name,
+                    dir.entryList(QStringList(info.fileName() + ".cold.*"), QDir::Files)) {
+                dir.remove(name);
+            }
+        }
+    }
+
+    // Saving before every item is published would drop the remaining ones
+    m_loading = true;
+    bool loaded = true;
+    bool catalogCovered = false;
+    CatalogFile file;
+    if (file.open(filename)) {
+        catalogCovered = !rotated.isEmpty() && file.journalFingerprint() == fingerprint;
+        // Remove any existing catalog contents
+        m_timestamp = 0;
+        clear();
+        // The catalog is saved with the most used items first
+        int batch = LOAD_BATCH_SIZE;
+        for (int begin = 0; begin < file.count(); begin += batch, batch *= 2) {
+            loadItems(file, begin, qMin(file.count(), begin + batch));
+            commitUpdate();
+            qDebug() << "Catalog::load, published" << count() << "of" << file.count() << "items";
+        }
+        commitUpdate();
+    }
+    else {
+        // Catalogs written by older versions are a compressed QDataStream,
+        // they are converted to the binary format the next time the catalog is saved
+        loaded = loadLegacy(filename);
+    }
+    // A crash after saving may leave the rotated journal behind, the files
+    // that already include its records skip them. It is removed before saves
+    // can rotate the journal into it again
+    if (catalogCovered && frecencyCovered) {
+        QMutexLocker locker(&m_usageMutex);
+        m_journal.removeRotated();
+    }
+
+    // A save before the records are replayed would drop them with the journal
+    replayJournal(rotated, !catalogCovered, !frecencyCovered);
+    replayJournal(records, true, true);
+    m_loading = false;
+
+    {
+        QMutexLocker locker(&m_usageMutex);
+        m_loaded = true;
+        m_loadExpected = false;
+        m_loadFinished.wakeAll();
+    }
+    return loaded;
+}
+
+
+void Catalog::loadItems(const CatalogFile& file, int begin, int end) {
+    if (begin == 0) {
+        reserve(file.count());
+    }
+    for (int i = begin; i < end; ++i) {
+        addItem(file.item(i));
+    }
+}
+
+
+// Save the catalog and the launch history to the specified filename
+bool Catalog::save(const QString& filename) {
+    QMutexLocker saveLocker(&m_saveMutex);
+
+    // The usage is pinned together with rotating the journal, so the rotated
+    // journal holds exactly the changes that are being saved. The pinned
+    // generation stays valid while newer ones are published
+    std::shared_ptr<const CatalogUsageMap> usage;
+    std::shared_ptr<const CatalogGeneration> generation;
+    FrecencyStore frecency;
+    QString frecencyFilename;
+    bool rotated = false;
+    quint32 fingerprint = 0;
+    {
+        QMutexLocker locker(&m_usageMutex);
+        m_savePending = false;
+        if (m_loading || m_loadExpected) {
+            // The journal keeps the usage changes until the next save
+            qDebug("Catalog::save, skipped until the catalog is loaded");
+            return false;
+        }
+        usage = std::atomic_load(&m_usage);
+        generation = std::atomic_load(&m_current);
+        frecency = m_frecency;
+        frecencyFilename = m_frecencyFilename;
+        if (m_journal.isOpen()) {
+            rotated = m_journal.rotate();
+            if (rotated) {
+                fingerprint = m_journal.rotatedFingerprint();
+            }
+        }
+    }
+
+    // The launch history is saved first, a crash before the catalog is saved
+    // leaves only usage counts to replay, which do not depend on it
+    frecency.setJournalFingerprint(fingerprint);
+    if (!frecencyFilename.isEmpty() && !frecency.save(frecencyFilename)) {
+        return false;
+    }
+
+    // Write the most used items first, they are the first ones published when loading
+    int itemCount = generation->store.count();
+    QVector<float> scores(itemCount);
+    QVector<int> order(itemCount);
+    for (int i = 0; i < itemCount; ++i) {
+        CatItemRef ref = itemRef(*generation, *usage, i);
+        scores[i] = ref.usage < 0 ? FrecencyStore::NONE : ref.frecency;
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&scores](int a, int b) {
+                         return scores.at(a) > scores.at(b);
+                     });
+
+    CatalogFileWriter writer;
+    writer.reserve(itemCount + (generation->cold ? generation->cold->count() : 0));
+    writer.setJournalFingerprint(fingerprint);
+    foreach(int slot, order) {
+        writer.addItem(getItem(*generation, *usage, slot));
+    }
+
+    // Cold items were moved out for their low scores, they go last
+    if (generation->cold) {
+        const CatalogColdSegment& cold = *generation->cold;
+        for (int i = 0; i < cold.count(); ++i) {
+            CatItem item = cold.item(i);
+            CatalogUsageMap::const_iterator it = usage->constFind(cold.key(i));
+            if (it != usage->constEnd()) {
+                item.usage = it.value().usage;
+            }
+            writer.addItem(item);
+        }
+    }
+
+    // The catalog is written to a temporary file which replaces the old one
+    // only once it is complete, so a crash never leaves a partial catalog
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Catalog::save, Could not open catalog file for writing");
+        return false;
+    }
+    if (!writer.write(&file)) {
+        qWarning() << "Catalog::save, Could not write catalog file" << file.errorString();
+        file.cancelWriting();
+        return false;
+    }
+    if (!file.commit()) {
+        qWarning() << "Catalog::save, Could not replace catalog file" << file.errorString();
+        return false;
+    }
+
+    // Both files hold the journaled changes now
+    if (rotated) {
+        QMutexLocker locker(&m_usageMutex);
+        m_journal.removeRotated();
+    }
+    return true;
+}
+
+
+void Catalog::saveInBackground(const QString& filename) {
+    QMutexLocker locker(&m_usageMutex);
+    scheduleSave(filename);
+}
+
+
+void Catalog::scheduleSave(const QString& filename) {
+    // A waiting save pins the catalog when it starts, so it covers later changes as well
+    if (m_savePending) {
+        return;
+    }
+    m_savePending = true;
+    m_saveFuture = QtConcurrent::run([this, filename]() {
+        return save(filename);
+    });
+}
+
+
+void Catalog::waitForSave() {
+    QFuture<bool> future;
+    {
+        QMutexLocker locker(&m_usageMutex);
+        future = m_saveFuture;
+    }
+    // Saves run one after another, the last one finishes last
+    future.waitForFinished();
+}
+
+
+void Catalog::waitForLoad() {
+    QMutexLocker locker(&m_usageMutex);
+    while (m_loadExpected) {
+        m_loadFinished.wait(&m_usageMutex);
+    }
+}
+
+
+void Catalog::setFiles(const QString& catalogFilename, const QString& frecencyFilename,
+                       const QString& journalFilename) {
+    QMutexLocker locker(&m_usageMutex);
+    m_filename = catalogFilename;
+    if (!m_loaded && !catalogFilename.isEmpty()) {
+        m_loadExpected = true;
+    }
+    m_frecencyFilename = frecencyFilename;
+    m_journalFilename = journalFilename;
+
+    // Records are only appended, reading the journal while it is open is fine
+    m_journal.close();
+    if (!journalFilename.isEmpty()) {
+        m_journal.open(journalFilename);
+    }
+}
+
+
+void Catalog::replayJournal(const QVector<UsageJournalRecord>& records, bool usage, bool frecency) {
+    if (records.isEmpty() || (!usage && !frecency)) {
+        return;
+    }
+
+    QMutexLocker locker(&m_usageMutex);
+    std::shared_ptr<const CatalogGeneration> generation = std::atomic_load(&m_current);
+    std::shared_ptr<CatalogUsageMap> updated
+        = std::make_shared<CatalogUsageMap>(*std::atomic_load(&m_usage));
+    FrecencyStore previous = m_frecency;
+    foreach(const UsageJournalRecord& record, records) {
+        int slot = generation->slotIndex.value(record.key, -1);
+        applyUsage(*generation, *updated, record.key, slot, 0,
+                   record.operation == UsageJournalRecord::Demote, record.time);
+    }
+
+    // Launches the launch history already includes are not added twice,
+    // the usage changes are scored with the history that is kept
+    if (!frecency) {
+        m_frecency = previous;
+        for (CatalogUsageMap::iterator it = updated->begin(); it != updated->end(); ++it) {
+            it.value().frecency = m_frecency.score(it.key(), it.value().usage);
+        }
+    }
+    if (usage) {
+        std::atomic_store(&m_usage, std::shared_ptr<const CatalogUsageMap>(updated));
+    }
+    qDebug() << "Catalog::replayJournal, replayed" << records.size() << "usage changes, counts"
+             << usage << "launch history" << frecency;
+}
+
+
+bool Catalog::loadLegacy(const QString& filename) {
     QFile inFile(filename);
     if (!inFile.open(QIODevice::ReadOnly)) {
         qWarning("Catalog::load, Could not open catalog file for reading");
@@ -47,6 +377,11 @@ bool Catalog::load(const QString& filename) {
 
     QByteArray ba = inFile.readAll();
     QByteArray unzipped = qUncompress(ba);
+    if (!ba.isEmpty() && unzipped.isEmpty()) {
+        // Neither a binary catalog nor a legacy one, e.g. it failed the checksum
+        qWarning("Catalog::load, Could not read catalog file, it has to be rebuilt");
+        return false;
+    }
     QDataStream in(&unzipped, QIODevice::ReadOnly);
     in.setVersion(QDataStream::Qt_4_2);
 
@@ -55,101 +390,699 @@ bool Catalog::load(const QString& filename) {
         in >> item;
         addItem(item);
     }
+    commitUpdate();
 
     return true;
 }
 
 
-// Save the catalog to the specified filename
-bool Catalog::save(const QString& filename) {
-    // Prevent other threads accessing the catalog
+void Catalog::incrementTimestamp() {
+    ++m_timestamp;
+}
+
+
+void Catalog::beginUpdate() {
     QMutexLocker locker(&m_mutex);
+    nextGeneration();
+}
 
-    QByteArray ba;
-    QDataStream out(&ba, QIODevice::ReadWrite);
-    out.setVersion(QDataStream::Qt_4_2);
 
-    for (int i = 0; i < count(); i++) {
-        CatItem item = getItem(i);
-        out << item;
+void Catalog::commitUpdate() {
+    QMutexLocker locker(&m_mutex);
+    if (!m_next) {
+        return;
     }
 
-    // Compress and write the catalog to the specified file
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning("Catalog::save, Could not open catalog file for writing");
-        return false;
+    enforceBudget(*m_next);
+
+    // Usage changed while the generation was prepared is carried over,
+    // the map keeps it until the generation including it is published
+    std::shared_ptr<const CatalogUsageMap> usage;
+    {
+        QMutexLocker usageLocker(&m_usageMutex);
+        usage = std::atomic_load(&m_usage);
+        // Items used before they were added take their usage along
+        const QHash<quint64, int>& pending = m_frecency.pendingUsage();
+        for (QHash<quint64, int>::const_iterator it = pending.constBegin(); it != pending.constEnd(); ++it) {
+            int slot = m_next->slotIndex.value(it.key(), -1);
+            if (slot >= 0) {
+                m_next->store.setUsage(slot, it.value());
+            }
+        }
+        for (CatalogUsageMap::const_iterator it = usage->constBegin(); it != usage->constEnd(); ++it) {
+            int slot = m_next->slotIndex.value(it.key(), -1);
+            if (slot >= 0) {
+                m_next->store.setUsage(slot, it.value().usage);
+            }
+        }
+
+        // Scores are precomputed so ranking never touches the launch history
+        CatalogStore& store = m_next->store;
+        for (int i = 0; i < store.count(); ++i) {
+            store.setFrecency(i, m_frecency.score(store.key(i), store.usage(i)));
+        }
     }
-    file.write(qCompress(ba));
-    return true;
+
+    // Sorting and indexing run without the usage lock, launches are not held up
+    m_next->sortSlots();
+    m_next->rebuildLengthIndex();
+    finishGeneration(*m_next);
+    m_next->id = ++m_lastId;
+
+    // Usage changed since it was copied to the store stays in the map, so does
+    // the usage of cold items, their segment is never modified
+    QMutexLocker usageLocker(&m_usageMutex);
+    std::shared_ptr<const CatalogUsageMap> current = std::atomic_load(&m_usage);
+    std::shared_ptr<CatalogUsageMap> remaining = std::make_shared<CatalogUsageMap>();
+    for (CatalogUsageMap::const_iterator it = current->constBegin(); it != current->constEnd(); ++it) {
+        CatalogUsageMap::const_iterator copied = usage->constFind(it.key());
+        bool changed = copied == usage->constEnd()
+            || copied.value().usage != it.value().usage
+            || copied.value().frecency != it.value().frecency;
+        if (changed || (m_next->cold && m_next->cold->find(it.key()) >= 0)) {
+            remaining->insert(it.key(), it.value());
+        }
+    }
+
+    // The catalog holds the pending usage from now on. Usage changed since it
+    // was copied, or of items that went straight to the cold segment, moves to the map
+    QList<quint64> pendingKeys = m_frecency.pendingUsage().keys();
+    foreach(quint64 key, pendingKeys) {
+        int usage = m_frecency.pendingUsage().value(key);
+        int slot = m_next->slotIndex.value(key, -1);
+        bool cold = slot < 0 && m_next->cold && m_next->cold->find(key) >= 0;
+        if (slot < 0 && !cold) {
+            continue;
+        }
+        if (cold || m_next->store.usage(slot) != usage) {
+            CatalogUsage changed;
+            changed.usage = usage;
+            changed.frecency = m_frecency.score(key, usage);
+            remaining->insert(key, changed);
+        }
+        m_frecency.removePendingUsage(key);
+    }
+
+    qDebug() << "Catalog::commitUpdate, publishing generation" << m_next->id
+             << "with" << m_next->store.count() << "items";
+    std::shared_ptr<const CatalogGeneration> published = std::move(m_next);
+    std::atomic_store(&m_current, published);
+    std::atomic_store(&m_usage, std::shared_ptr<const CatalogUsageMap>(remaining));
 }
 
 
-void Catalog::incrementTimestamp() {
-    ++m_timestamp;
+void Catalog::abortUpdate() {
+    QMutexLocker locker(&m_mutex);
+    if (m_next) {
+        qDebug() << "Catalog::abortUpdate, dropping the prepared generation";
+        m_next.reset();
+    }
 }
 
-// Return true if the specified catalog item matches the specified string
-bool Catalog::matches(CatItem* item, const QString& match) {
-    int matchLength = match.count();
-    int curChar = 0;
 
-    foreach(QChar c, item->searchName[CatItem::LOWER]) {
-        if (c == match[curChar]) {
-            ++curChar;
-            if (curChar >= matchLength) {
-                return true;
+void Catalog::enforceBudget(CatalogGeneration& generation) {
+    // The budget is in KiB, 0 keeps every item in memory
+    qint64 budget = (qint64)g_settings->value(OPTION_MEMORYBUDGET, OPTION_MEMORYBUDGET_DEFAULT).toInt() * 1024;
+    CatalogStore& store = generation.store;
+    int count = store.count();
+    qint64 resident = generation.memoryUsage();
+    if (budget <= 0 || count == 0 || resident <= budget) {
+        return;
+    }
+
+    // Score the items as save orders them, demoted items go first
+    QVector<float> scores(count);
+    std::shared_ptr<const CatalogUsageMap> usage;
+    QString filename;
+    {
+        QMutexLocker locker(&m_usageMutex);
+        usage = std::atomic_load(&m_usage);
+        filename = m_filename;
+        for (int i = 0; i < count; ++i) {
+            CatItemRef ref = itemRef(generation, *usage, i);
+            scores[i] = ref.usage < 0 ? FrecencyStore::NONE
+                                      : m_frecency.score(ref.key, ref.usage);
+        }
+    }
+    if (filename.isEmpty()) {
+        return;
+    }
+
+    // Items are assumed to be of average size
+    int keep = (int)(count * (budget * BUDGET_EVICT_PERCENT / 100) / resident);
+    QVector<int> order(count);
+    for (int i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&scores](int a, int b) {
+                         return scores.at(a) > scores.at(b);
+                     });
+
+    // The new segment holds the evicted items and the items of the current one.
+    // Rewriting the cold items costs O(cold) per eviction, which is bounded:
+    // an eviction leaves the resident items BUDGET_EVICT_PERCENT of the budget,
+    // so the next one only comes once that headroom is used up, and segments
+    // stay single files that searches map and scan in one pass
+    CatalogFileWriter writer;
+    QVector<bool> removed(count, false);
+    for (int i = keep; i < count; ++i) {
+        removed[order.at(i)] = true;
+        writer.addItem(getItem(generation, *usage, order.at(i)));
+    }
+    if (generation.cold) {
+        const CatalogColdSegment& cold = *generation.cold;
+        for (int i = 0; i < cold.count(); ++i) {
+            // An item added again is in store and is written from there
+            if (generation.slotIndex.contains(cold.key(i))) {
+                continue;
+            }
+            CatItem item = cold.item(i);
+            CatalogUsageMap::const_iterator it = usage->constFind(cold.key(i));
+            if (it != usage->constEnd()) {
+                item.usage = it.value().usage;
             }
+            writer.addItem(item);
         }
     }
 
-    foreach(QChar c, item->searchName[CatItem::TRANS]) {
-        if (c == match[curChar]) {
-            ++curChar;
-            if (curChar >= matchLength) {
-                return true;
+    // Searches may still read the current segment, so every segment has its own file
+    QString coldFilename = filename + ".cold." + QString::number(++m_coldSerial);
+    QSaveFile file(coldFilename);
+    if (!file.open(QIODevice::WriteOnly) || !writer.write(&file) || !file.commit()) {
+        qWarning() << "Catalog::enforceBudget, Could not write cold segment" << file.errorString();
+        return;
+    }
+    std::shared_ptr<CatalogColdSegment> cold = std::make_shared<CatalogColdSegment>();
+    if (!cold->open(coldFilename)) {
+        return;
+    }
+
+    float threshold = keep < count ? scores.at(order.at(keep)) : FrecencyStore::NONE;
+    store.remove(removed);
+    store.squeeze();
+    generation.rebuildSlotIndex();
+    generation.indexDirty = true;
+    generation.cold = cold;
+
+    qDebug() << "Catalog::enforceBudget, moved" << count - keep << "items with scores up to"
+             << threshold << "to the cold segment, resident" << store.count() << "items,"
+             << generation.memoryUsage() / 1024 << "KiB, cold" << cold->count() << "items,"
+             << cold->size() / 1024 << "KiB";
+}
+
+
+CatalogGeneration& Catalog::nextGeneration() {
+    if (!m_next) {
+        m_next = std::make_shared<CatalogGeneration>(*std::atomic_load(&m_current));
+    }
+    return *m_next;
+}
+
+
+void Catalog::finishGeneration(CatalogGeneration& generation) {
+    Q_UNUSED(generation)
+}
+
+
+int Catalog::count() {
+    std::shared_ptr<const CatalogGeneration> generation = std::atomic_load(&m_current);
+    return generation->store.count() + (generation->cold ? generation->cold->count() : 0);
+}
+
+CatalogMemoryStats Catalog::memoryStats() const {
+    std::shared_ptr<const CatalogGeneration> generation = std::atomic_load(&m_current);
+    CatalogMemoryStats stats;
+    stats.residentCount = generation->store.count();
+    stats.residentBytes = generation->memoryUsage();
+    stats.coldCount = generation->cold ? generation->cold->count() : 0;
+    stats.coldBytes = generation->cold ? generation->cold->size() : 0;
+    stats.coldSearches = m_coldSearches;
+    stats.coldHits = m_coldHits;
+    return stats;
+}
+
+bool Catalog::containsItems(const QVector<quint64>& keys) const {
+    std::shared_ptr<const CatalogGeneration> generation = std::atomic_load(&m_current);
+    foreach(quint64 key, keys) {
+        if (!generation->slotIndex.contains(key)
+            && (!generation->cold || generation->cold->find(key) < 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int Catalog::touchItems(const QVector<quint64>& keys) {
+    int touched = 0;
+    QList<CatItem> coldItems;
+    {
+        // Prevent other writers accessing the prepared generation
+        QMutexLocker locker(&m_mutex);
+
+        CatalogGeneration& generation = nextGeneration();
+        foreach(quint64 key, keys) {
+            QHash<quint64, int>::const_iterator it = generation.slotIndex.constFind(key);
+            if (it != generation.slotIndex.constEnd()) {
+                generation.store.setTimestamp(it.value(), m_timestamp);
+                ++touched;
+                continue;
+            }
+
+            int coldIndex = generation.cold ? generation.cold->find(key) : -1;
+            if (coldIndex >= 0) {
+                coldItems.push_back(generation.cold->item(coldIndex));
+                ++touched;
             }
         }
     }
 
-    return false;
+    // A rebuild adds the cold items that still exist to the store again
+    foreach(const CatItem& item, coldItems) {
+        addItem(item);
+    }
+    return touched;
+}
+
+
+void Catalog::incrementUsage(const CatItem& item) {
+    updateUsage(item, false);
+}
+
+
+void Catalog::demoteItem(const CatItem& item) {
+    updateUsage(item, true);
+}
+
+
+// Usage changes are kept in a small copy-on-write map next to the published
+// generation, so they never have to wait for the builder
+void Catalog::updateUsage(const CatItem& item, bool demote) {
+    bool sync = g_settings->value(OPTION_SYNCJOURNAL, OPTION_SYNCJOURNAL_DEFAULT).toBool();
+    QMutexLocker locker(&m_usageMutex);
+
+    std::shared_ptr<const CatalogGeneration> generation = std::atomic_load(&m_current);
+    std::shared_ptr<CatalogUsageMap> updated
+        = std::make_shared<CatalogUsageMap>(*std::atomic_load(&m_usage));
+    quint64 key = itemKey(item);
+    qint64 time = QDateTime::currentSecsSinceEpoch();
+    applyUsage(*generation, *updated, key, generation->findItem(item), item.usage, demote, time);
+    std::atomic_store(&m_usage, std::shared_ptr<const CatalogUsageMap>(updated));
+
+    // Only the change itself is written now, the catalog is saved
+    // in the background once enough changes have piled up
+    m_journal.append(key, demote ? UsageJournalRecord::Demote : UsageJournalRecord::Launch,
+                     time, sync);
+    if (m_journal.count() >= JOURNAL_SAVE_COUNT && !m_filename.isEmpty()) {
+        scheduleSave(m_filename);
+    }
+}
+
+
+void Catalog::applyUsage(const CatalogGeneration& generation, CatalogUsageMap& usage,
+                         quint64 key, int slot, int itemUsage, bool demote, qint64 time) {
+    int coldIndex = slot < 0 && generation.cold ? generation.cold->find(key) : -1;
+    int count = slot >= 0 ? generation.store.usage(slot)
+        : coldIndex >= 0 ? generation.cold->usage(coldIndex)
+        : m_frecency.pendingUsage().value(key, itemUsage);
+    CatalogUsageMap::const_iterator it = usage.constFind(key);
+    if (it != usage.constEnd()) {
+        count = it.value().usage;
+    }
+
+    if (demote) {
+        // If an item is not demoted, demote it, otherwise demote it further
+        count = count > 0 ? -1 : count - 1;
+    }
+    else {
+        // If an item is currently demoted, return it to a usage count of 1
+        // and forget the launches from before it was demoted
+        if (count < 0) {
+            m_frecency.reset(key);
+        }
+        count = count < 0 ? 1 : count + 1;
+        // Launches of items from outside the catalog are recorded as well,
+        // they still rank plugin results
+        m_frecency.addLaunch(key, time);
+    }
+    if (slot < 0 && coldIndex < 0) {
+        // Saving drops the journal, the launch history keeps the usage
+        // until the item is added to the catalog
+        m_frecency.setPendingUsage(key, count);
+        return;
+    }
+
+    CatalogUsage changed;
+    changed.usage = count;
+    changed.frecency = m_frecency.score(key, count);
+    usage.insert(key, changed);
+}
+
+// Return true if the specified catalog item matches the specified string
+bool Catalog::matches(CatItem* item, const QString& match) {
+    const QString& lower = item->searchName[CatItem::LOWER];
+    const QString& trans = item->searchName[CatItem::TRANS];
+    int matchLength = match.size();
+
+    // The match continues into the trans name where the lower name left off
+    int curChar = subsequenceMatch(lower.constData(), lower.size(), match.constData(), matchLength);
+    if (curChar < matchLength) {
+        curChar += subsequenceMatch(trans.constData(), trans.size(),
+                                    match.constData() + curChar, matchLength - curChar);
+    }
+    return curChar >= matchLength;
+}
+
+
+quint64 Catalog::itemKey(const CatItem& item) {
+    return CatalogStore::makeKey(QStringRef(&item.fullPath), QStringRef(&item.shortName));
 }
 
 
 // Search the catalog, for items matching the text parameter and
 // populate the out parameter
-void Catalog::searchCatalogs(const QString& text, QList<CatItem>& out) {
-    // Prevent other threads accessing the catalog
-    QMutexLocker locker(&m_mutex);
+void Catalog::searchCatalogs(const QString& text, QList<CatItem>& out, CatalogSearchCache* cache) {
+    QString lowText = text.toLower();
+    if (lowText.isEmpty()) {
+        return;
+    }
 
-    QList<CatItem*> catMatches = search(text);
-    qDebug() << "Catalog::searchCatalogs, search matched count:" << catMatches.count();
-    // Now prioritize the catalog items
-    qSort(catMatches.begin(), catMatches.end(), CatLessPtr);
+    // Pin the current generation, the builder publishes new ones without waiting
+    std::shared_ptr<const CatalogUsageMap> usage = std::atomic_load(&m_usage);
+    std::shared_ptr<const CatalogGeneration> generation = std::atomic_load(&m_current);
+
+    // The slots that have to be checked, every slot when domain is null
+    const QVector<int>* domain = nullptr;
+    // Set when the domain is already known to match the search text
+    bool domainMatches = false;
+    QVector<int> candidates;
+    if (cache) {
+        // Slots cached for an older generation of the catalog are meaningless
+        if (cache->m_generation != generation->id) {
+            cache->clear();
+            cache->m_generation = generation->id;
+        }
 
-    // Check for history matches
-    QString location = "History/" + text;
-    QStringList hist;
-    hist = g_settings->value(location).toStringList();
-    if (hist.count() == 2) {
-        for (int i = 0; i < catMatches.count(); i++) {
-            if (catMatches[i]->searchName == hist[0]
-                && catMatches[i]->fullPath == hist[1]) {
-                CatItem* tmp = catMatches[i];
-                catMatches.removeAt(i);
-                catMatches.push_front(tmp);
-            }
+        // Forget the queries the search text no longer extends
+        while (!cache->m_queries.isEmpty() && !lowText.startsWith(cache->m_queries.last())) {
+            cache->m_queries.removeLast();
+            cache->m_matches.removeLast();
         }
+
+        // Every item matching the search text also matches any prefix of it,
+        // so only the items matched by the longest cached prefix are checked
+        if (!cache->m_queries.isEmpty()) {
+            domain = &cache->m_matches.last();
+            // Same text as a cached query, e.g. after a backspace
+            domainMatches = cache->m_queries.last() == lowText;
+        }
+    }
+    if (!domain && findCandidates(*generation, lowText, candidates)) {
+        domain = &candidates;
+    }
+
+    int numResults = g_settings->value(OPSTION_NUMRESULT, OPSTION_NUMRESULT_DEFAULT).toInt();
+    const CatalogStore& store = generation->store;
+
+    // The item last launched for this text goes first if it matches
+    int historySlot = -1;
+    QStringList history = g_settings->value("History/" + text).toStringList();
+    if (history.count() == 2) {
+        int slot = generation->slotIndex.value(
+            CatalogStore::makeKey(QStringRef(&history[1]), QStringRef(&history[0])), -1);
+        if (slot >= 0 && store.shortName(slot) == history[0]
+            && store.hasFullPath(slot, history[1]) && store.matches(slot, lowText)) {
+            historySlot = slot;
+        }
+    }
+
+    // The slots are in CatOrder, except for the items whose usage changed since
+    // the generation was published. They are ranked before the others together
+    // with the candidates for an exact match, which rank first regardless of order
+    QVector<int> pinned;
+    for (CatalogUsageMap::const_iterator it = usage->constBegin(); it != usage->constEnd(); ++it) {
+        int slot = generation->slotIndex.value(it.key(), -1);
+        if (slot >= 0) {
+            pinned.push_back(slot);
+        }
+    }
+    if (lowText.size() < generation->lengthIndex.size()) {
+        pinned += generation->lengthIndex.at(lowText.size());
+    }
+    std::sort(pinned.begin(), pinned.end());
+    pinned.erase(std::unique(pinned.begin(), pinned.end()), pinned.end());
+
+    // Large searches are split into shards which are matched and ranked
+    // on the global thread pool, each shard keeps its own top results
+    int domainSize = domain ? domain->size() : generation->store.count();
+    int threshold = g_settings->value(OPTION_PARALLELSEARCH, OPTION_PARALLELSEARCH_DEFAULT).toInt();
+    int shardCount = 1;
+    if (threshold > 0 && domainSize >= threshold) {
+        shardCount = qMax(1, QThread::idealThreadCount());
+    }
+
+    QVector<CatalogSearchShard> shards(shardCount);
+    for (int i = 0; i < shardCount; ++i) {
+        shards[i].begin = (int)((qint64)domainSize * i / shardCount);
+        shards[i].end = (int)((qint64)domainSize * (i + 1) / shardCount);
+    }
+
+    auto runShard = [&](CatalogSearchShard& shard) {
+        searchShard(shard, *generation, *usage, lowText, domain, domainMatches, pinned, numResults);
+    };
+    if (shardCount == 1) {
+        runShard(shards[0]);
+    }
+    else {
+        QtConcurrent::blockingMap(shards, runShard);
+    }
+
+    // Merge the shards, they cover the domain in order
+    QVector<int> matched;
+    QVector<int> top;
+    bool complete = true;
+    foreach(const CatalogSearchShard& shard, shards) {
+        matched += shard.matched;
+        top += shard.top;
+        complete = complete && shard.complete;
+    }
+    qDebug() << "Catalog::searchCatalogs, search matched count:" << matched.count()
+             << "shards:" << shardCount << "stopped early:" << !complete;
+
+    // A search that stopped early did not find every match and is not cached
+    if (cache && !domainMatches && complete) {
+        cache->m_queries.push_back(lowText);
+        cache->m_matches.push_back(matched);
+    }
+
+    // Now prioritize the best items of all shards
+    if (shardCount > 1) {
+        selectTopItems(*generation, *usage, top, lowText, numResults);
+    }
+
+    if (historySlot >= 0) {
+        top.removeOne(historySlot);
+        top.push_front(historySlot);
     }
 
     // Load up the results
-    int max = g_settings->value(OPSTION_NUMRESULT, OPSTION_NUMRESULT_DEFAULT).toInt();
-    for (int i = 0; i < max && i < catMatches.count(); i++) {
-        out.push_back(*catMatches[i]);
+    QList<CatItem> results;
+    for (int i = 0; i < numResults && i < top.count(); i++) {
+        results.push_back(getItem(*generation, *usage, top.at(i)));
+    }
+
+    // The cold segment is only searched when the resident items do not fill the results,
+    // a search only stops early once they do
+    if (generation->cold && matched.count() < numResults) {
+        QList<CatItem> found;
+        searchColdSegment(*generation, *usage, lowText, found);
+        if (!found.isEmpty()) {
+            // Rank the cold items among the resident ones, the item last launched stays first
+            CatItem historyItem;
+            bool hasHistory = historySlot >= 0 && !results.isEmpty();
+            if (hasHistory) {
+                historyItem = results.takeFirst();
+            }
+            results += found;
+            sortItems(results, lowText);
+            if (hasHistory) {
+                results.push_front(historyItem);
+            }
+        }
+    }
+
+    for (int i = 0; i < numResults && i < results.count(); i++) {
+        out.push_back(results.at(i));
+    }
+}
+
+
+void Catalog::searchColdSegment(const CatalogGeneration& generation, const CatalogUsageMap& usage,
+                                const QString& text, QList<CatItem>& found) {
+    const CatalogColdSegment& cold = *generation.cold;
+    for (int i = 0; i < cold.count(); ++i) {
+        if (!cold.matches(i, text)) {
+            continue;
+        }
+        CatItem item = cold.item(i);
+        CatalogUsageMap::const_iterator it = usage.constFind(cold.key(i));
+        if (it != usage.constEnd()) {
+            item.usage = it.value().usage;
+        }
+        found.push_back(item);
+    }
+
+    int searches = ++m_coldSearches;
+    int hits = found.isEmpty() ? m_coldHits.load() : ++m_coldHits;
+    qDebug() << "Catalog::searchColdSegment, found" << found.count() << "of" << cold.count()
+             << "cold items, the cold segment added results to" << hits << "of" << searches
+             << "searches";
+}
+
+
+// Match and rank the slots of one shard of the domain. The domain is in CatOrder,
+// so once the shard has numResults matches that rank better than any item
+// left can, the rest of the shard is skipped
+void Catalog::searchShard(CatalogSearchShard& shard, const CatalogGeneration& generation,
+                          const CatalogUsageMap& usage, const QString& text,
+                          const QVector<int>* domain, bool domainMatches,
+                          const QVector<int>& pinned, int numResults) {
+    const CatalogStore& store = generation.store;
+    // The best matches so far, the worst of them on top
+    typedef std::pair<CatRank, int> RankedSlot;
+    auto rankLess = [](const RankedSlot& a, const RankedSlot& b) {
+        return a.first < b.first;
+    };
+    std::priority_queue<RankedSlot, std::vector<RankedSlot>, decltype(rankLess)> best(rankLess);
+    auto addMatch = [&](int slot) {
+        shard.matched.push_back(slot);
+        RankedSlot ranked(CatRank(itemRef(generation, usage, slot), text), slot);
+        if ((int)best.size() < numResults) {
+            best.push(ranked);
+        }
+        else if (numResults > 0 && ranked.first < best.top().first) {
+            best.pop();
+            best.push(ranked);
+        }
+    };
+
+    // Rank the pinned slots of this shard first, the scan skips them
+    const int* first = domain ? domain->constData() + shard.begin : nullptr;
+    const int* last = domain ? domain->constData() + shard.end : nullptr;
+    foreach(int slot, pinned) {
+        bool inShard = domain ? std::binary_search(first, last, slot)
+                              : slot >= shard.begin && slot < shard.end;
+        if (inShard && (domainMatches || store.matches(slot, text))) {
+            addMatch(slot);
+        }
+    }
+    int pinnedMatches = shard.matched.size();
+
+    // Items of the length of text are pinned, the others cannot match it exactly
+    bool exact = text.size() >= generation.lengthIndex.size();
+    int nextPinned = 0;
+    for (int i = shard.begin; i < shard.end; ++i) {
+        int slot = domain ? domain->at(i) : i;
+        while (nextPinned < pinned.size() && pinned.at(nextPinned) < slot) {
+            ++nextPinned;
+        }
+        if (nextPinned < pinned.size() && pinned.at(nextPinned) == slot) {
+            continue;
+        }
+
+        if ((int)best.size() == numResults && numResults > 0) {
+            CatOrder order(store.usage(slot), store.frecency(slot), store.shortName(slot).count());
+            if (best.top().first < CatRank(order, text, exact)) {
+                shard.complete = false;
+                break;
+            }
+        }
+
+        if (!domainMatches && !store.matches(slot, text)) {
+            continue;
+        }
+        addMatch(slot);
+    }
+
+    // Cached matches are a domain and have to stay in slot order
+    std::inplace_merge(shard.matched.begin(), shard.matched.begin() + pinnedMatches,
+                       shard.matched.end());
+
+    shard.top.resize((int)best.size());
+    for (int i = shard.top.size() - 1; i >= 0; --i) {
+        shard.top[i] = best.top().second;
+        best.pop();
     }
 }
 
 
+void Catalog::selectTopItems(const CatalogGeneration& generation, const CatalogUsageMap& usage,
+                             QVector<int>& slots, const QString& text, int count) {
+    // Rank every matched item once, then only order the best count of them
+    QVector<CatRank> ranks;
+    ranks.reserve(slots.size());
+    foreach(int slot, slots) {
+        ranks.push_back(CatRank(itemRef(generation, usage, slot), text));
+    }
+
+    QVector<int> order(ranks.size());
+    for (int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    int topCount = qBound(0, count, order.size());
+    auto rankLess = [&ranks](int a, int b) {
+        return ranks.at(a) < ranks.at(b);
+    };
+    if (topCount < order.size()) {
+        // Move the best items to the front before sorting just those
+        std::nth_element(order.begin(), order.begin() + topCount, order.end(), rankLess);
+    }
+    std::sort(order.begin(), order.begin() + topCount, rankLess);
+
+    QVector<int> top(topCount);
+    for (int i = 0; i < topCount; ++i) {
+        top[i] = slots.at(order.at(i));
+    }
+    slots.swap(top);
+}
+
+
+CatItem Catalog::getItem(const CatalogGeneration& generation, const CatalogUsageMap& usage,
+                         int slot) {
+    CatItem item = generation.store.item(slot);
+    if (!usage.isEmpty()) {
+        CatalogUsageMap::const_iterator it = usage.constFind(generation.store.key(slot));
+        if (it != usage.constEnd()) {
+            item.usage = it.value().usage;
+        }
+    }
+    return item;
+}
+
+
+CatItemRef Catalog::itemRef(const CatalogGeneration& generation, const CatalogUsageMap& usage,
+                            int slot) {
+    CatItemRef ref = generation.store.itemRef(slot);
+    if (!usage.isEmpty()) {
+        CatalogUsageMap::const_iterator it = usage.constFind(generation.store.key(slot));
+        if (it != usage.constEnd()) {
+            ref.usage = it.value().usage;
+            ref.frecency = it.value().frecency;
+        }
+    }
+    return ref;
+}
+
+
+bool Catalog::findCandidates(const CatalogGeneration& generation, const QString& text,
+                             QVector<int>& result) const {
+    Q_UNUSED(generation)
+    Q_UNUSED(text)
+    Q_UNUSED(result)
+    return false;
+}
+
+
 void Catalog::promoteRecentlyUsedItems(const QString& text, QList<CatItem> & list) {
     // Check for history matches
     QString location = "History/" + text;
@@ -167,6 +1100,33 @@ void Catalog::promoteRecentlyUsedItems(const QString& text, QList<CatItem> & lis
     }
 }
 
+void Catalog::sortItems(QList<CatItem>& items, const QString& text) {
+    // Rank every item once, then sort the ranks
+    QVector<CatRank> ranks;
+    ranks.reserve(items.size());
+    QVector<int> order(items.size());
+    {
+        QMutexLocker locker(&m_usageMutex);
+        for (int i = 0; i < items.size(); ++i) {
+            CatItemRef ref(items.at(i));
+            ref.frecency = m_frecency.score(itemKey(items.at(i)), ref.usage);
+            ranks.push_back(CatRank(ref, text));
+            order[i] = i;
+        }
+    }
+    std::sort(order.begin(), order.end(),
+              [&ranks](int a, int b) {
+                  return ranks.at(a) < ranks.at(b);
+              });
+
+    QList<CatItem> sorted;
+    sorted.reserve(items.size());
+    foreach(int i, order) {
+        sorted.push_back(items.at(i));
+    }
+    items.swap(sorted);
+}
+
 QString Catalog::decorateText(const QString& text, const QString& match, bool outputRichText) {
     if (!g_settings->value(OPSTION_DECORATETEXT, OPSTION_DECORATETEXT_DEFAULT).toBool())
         return text;
@@ -215,212 +1175,381 @@ QString Catalog::decorateText(const QString& text, const QString& match, bool ou
 }
 
 
-int SlowCatalog::count() {
-    return m_catalogItems.count();
-}
-
+CatalogGeneration::CatalogGeneration()
+    : id(0),
+      indexDirty(false) {
 
-void SlowCatalog::clear() {
-    m_catalogItems.clear();
 }
 
-void SlowCatalog::addItem(const CatItem& item) {
-    // Prevent other threads accessing the catalog
-    QMutexLocker locker(&m_mutex);
+int CatalogGeneration::findItem(const CatItem& item) const {
+    QHash<quint64, int>::const_iterator it = slotIndex.constFind(Catalog::itemKey(item));
+    if (it == slotIndex.constEnd()) {
+        return -1;
+    }
 
-    bool replaced = false;
-
-    if (m_timestamp > 0) {
-        // If we're not loading the catalog, search for an existing matching catalog item
-        // and replace it if it exists
-        for (int i = 0; i < m_catalogItems.size(); ++i) {
-            if (item == m_catalogItems[i]) {
-                int usage = m_catalogItems[i].usage;
-                m_catalogItems[i] = CatalogItem(item, m_timestamp);
-                m_catalogItems[i].usage = usage;
-                replaced = true;
-                break;
-            }
+    if (store.equals(it.value(), item)) {
+        return it.value();
+    }
+
+    // Two different items share a key, fall back to a full scan
+    for (int i = 0; i < store.count(); ++i) {
+        if (store.equals(i, item)) {
+            return i;
         }
     }
+    return -1;
+}
 
-    if (!replaced) {
-        // If no match found, append the item to the catalog
-        qDebug() << "SlowCatalog::addItem, Adding" << item.fullPath;
-        m_catalogItems.push_back(CatalogItem(item, m_timestamp));
+qint64 CatalogGeneration::memoryUsage() const {
+    // A hash node holds the key, the value and the next pointer
+    qint64 size = store.memoryUsage()
+        + (qint64)slotIndex.capacity() * sizeof(void*)
+        + (qint64)slotIndex.size() * (sizeof(void*) + sizeof(uint) + sizeof(quint64) + sizeof(int));
+    for (QHash<ushort, QVector<int>>::const_iterator it = postings.constBegin();
+         it != postings.constEnd(); ++it) {
+        size += (qint64)it.value().capacity() * sizeof(int);
     }
+    foreach(const QVector<int>& slots, lengthIndex) {
+        size += (qint64)slots.capacity() * sizeof(int);
+    }
+    return size;
 }
 
+void CatalogGeneration::rebuildSlotIndex() {
+    slotIndex.clear();
+    slotIndex.reserve(store.count());
+    for (int i = 0; i < store.count(); ++i) {
+        slotIndex.insert(store.key(i), i);
+    }
+}
 
-void SlowCatalog::purgeOldItems() {
-    // Prevent other threads accessing the catalog
-    QMutexLocker locker(&m_mutex);
+void CatalogGeneration::sortSlots() {
+    QVector<CatOrder> orders;
+    orders.reserve(store.count());
+    for (int i = 0; i < store.count(); ++i) {
+        orders.push_back(CatOrder(store.usage(i), store.frecency(i), store.shortName(i).count()));
+    }
+    // Usually only the items added or launched since the last commit are out of order
+    if (std::is_sorted(orders.constBegin(), orders.constEnd())) {
+        return;
+    }
+
+    QVector<int> order(orders.size());
+    for (int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&orders](int a, int b) {
+                         return orders.at(a) < orders.at(b);
+                     });
+    store.reorder(order);
+    rebuildSlotIndex();
+    indexDirty = true;
+}
 
-    for (int i = m_catalogItems.size() - 1; i >= 0; --i) {
-        if (m_catalogItems.at(i).m_timestamp < m_timestamp) {
-            qDebug() << "SlowCatalog::purgeOldItems, Removing" << m_catalogItems.at(i).fullPath;
-            m_catalogItems.remove(i);
+void CatalogGeneration::rebuildLengthIndex() {
+    lengthIndex = QVector<QVector<int>>(LENGTH_INDEX_SIZE);
+    for (int i = 0; i < store.count(); ++i) {
+        int lower = store.searchName(i, CatItem::LOWER).size();
+        int trans = store.searchName(i, CatItem::TRANS).size();
+        if (lower < LENGTH_INDEX_SIZE) {
+            lengthIndex[lower].push_back(i);
+        }
+        if (trans != lower && trans < LENGTH_INDEX_SIZE) {
+            lengthIndex[trans].push_back(i);
         }
     }
 }
 
 
-void SlowCatalog::incrementUsage(const CatItem& item) {
-    // Prevent other threads accessing the catalog
+void SlowCatalog::clear() {
     QMutexLocker locker(&m_mutex);
+    nextGeneration() = CatalogGeneration();
+}
 
-    for (int i = 0; i < m_catalogItems.size(); ++i) {
-        if (item == m_catalogItems[i]) {
-            // If an item is currently demoted, return it to a usage count of 1
-            if (m_catalogItems[i].usage < 0) {
-                m_catalogItems[i].usage = 1;
-            }
-            else {
-                ++m_catalogItems[i].usage;
+void SlowCatalog::reserve(int count) {
+    QMutexLocker locker(&m_mutex);
+    CatalogGeneration& generation = nextGeneration();
+    generation.store.reserve(count);
+    generation.slotIndex.reserve(count);
+}
+
+void SlowCatalog::addItem(const CatItem& item) {
+    // Prevent other writers accessing the prepared generation
+    QMutexLocker locker(&m_mutex);
+
+    // If we're not loading the catalog, search for an existing matching catalog item
+    // and replace it if it exists
+    CatalogGeneration& generation = nextGeneration();
+    storeItem(generation, item, m_timestamp > 0 ? generation.findItem(item) : -1);
+}
+
+
+int SlowCatalog::purgeOldItems() {
+    // Prevent other writers accessing the prepared generation
+    QMutexLocker locker(&m_mutex);
+
+    // Mark the old items first and compact the store once, removing them one
+    // by one would shift the slots behind each of them
+    CatalogGeneration& generation = nextGeneration();
+    QVector<bool> removed(generation.store.count(), false);
+    for (int i = 0; i < generation.store.count(); ++i) {
+        if (generation.store.timestamp(i) < m_timestamp) {
+            qDebug() << "SlowCatalog::purgeOldItems, Removing" << generation.store.fullPath(i);
+            removed[i] = true;
+        }
+    }
+
+    int purged = generation.store.remove(removed);
+    if (purged > 0) {
+        generation.store.squeeze();
+        generation.rebuildSlotIndex();
+        generation.indexDirty = true;
+    }
+
+    // The rebuild added the cold items that still exist to store again
+    if (generation.cold) {
+        for (int i = 0; i < generation.cold->count(); ++i) {
+            if (!generation.slotIndex.contains(generation.cold->key(i))) {
+                ++purged;
             }
-            break;
         }
+        generation.cold.reset();
     }
+    return purged;
 }
 
-
-void SlowCatalog::demoteItem(const CatItem& item) {
-    // Prevent catalog refreshes whilst searching
+int SlowCatalog::removeItems(const QVector<quint64>& keys) {
+    // Prevent other writers accessing the prepared generation
     QMutexLocker locker(&m_mutex);
 
-    for (int i = 0; i < m_catalogItems.size(); ++i) {
-        if (item == m_catalogItems[i]) {
-            // If an item is not demoted, demote it
-            if (m_catalogItems[i].usage > 0) {
-                m_catalogItems[i].usage = -1;
-            }
-            else { // otherwise demote it further
-                --m_catalogItems[i].usage;
-            }
-            break;
+    CatalogGeneration& generation = nextGeneration();
+    QVector<bool> removed(generation.store.count(), false);
+    bool found = false;
+    foreach(quint64 key, keys) {
+        QHash<quint64, int>::const_iterator it = generation.slotIndex.constFind(key);
+        if (it != generation.slotIndex.constEnd()) {
+            qDebug() << "SlowCatalog::removeItems, Removing" << generation.store.fullPath(it.value());
+            removed[it.value()] = true;
+            found = true;
         }
     }
+    if (!found) {
+        return 0;
+    }
+
+    int count = generation.store.remove(removed);
+    generation.store.squeeze();
+    generation.rebuildSlotIndex();
+    generation.indexDirty = true;
+    return count;
 }
 
 
-const CatItem& SlowCatalog::getItem(int i) {
-    return m_catalogItems[i];
+void SlowCatalog::loadItems(const CatalogFile& file, int begin, int end) {
+    // Prevent other writers accessing the prepared generation
+    QMutexLocker locker(&m_mutex);
+
+    CatalogGeneration& generation = nextGeneration();
+    int first = generation.store.count();
+    generation.store.append(file, begin, end, m_timestamp);
+    for (int i = first; i < generation.store.count(); ++i) {
+        generation.slotIndex.insert(generation.store.key(i), i);
+    }
+    generation.indexDirty = true;
 }
 
-// Return a list of catalog items that match searchText
-// this method should only be called from within a QMutexLocker protected section
-QList<CatItem*> SlowCatalog::search(const QString& searchText) {
-    QList<CatItem*> result;
-    if (!searchText.isEmpty()) {
-        QString lowSearch = searchText.toLower();
-        for (int i = 0; i < m_catalogItems.count(); ++i) {
-            if (matches(&m_catalogItems[i], lowSearch)) {
-                result.push_back(&m_catalogItems[i]);
-            }
+int SlowCatalog::storeItem(CatalogGeneration& generation, const CatItem& item, int slot) {
+    if (slot < 0) {
+        // If no match found, append the item to the catalog
+        qDebug() << "SlowCatalog::storeItem, Adding" << item.fullPath;
+        slot = generation.store.append(item, m_timestamp);
+        quint64 key = generation.store.key(slot);
+        generation.slotIndex.insert(key, slot);
+        // An item coming back from the cold segment keeps its usage
+        int coldIndex = generation.cold ? generation.cold->find(key) : -1;
+        if (coldIndex >= 0) {
+            generation.store.setUsage(slot, generation.cold->usage(coldIndex));
         }
+        return slot;
     }
 
-    return result;
+    // Replace the existing item, keeping its usage,
+    // an equal item has the same key so the slot index is unchanged
+    generation.store.replace(slot, item, m_timestamp);
+    return slot;
 }
 
-bool CatLessRef(CatItem& a, CatItem& b) {
-    bool less = CatLessPtr(&a, &b);
-    /*	if (less)
-    qDebug() << a.lowName << "(" << a.usage << ") < " << b.lowName << " (" << b.usage << ")";
-    else
-    qDebug() << b.lowName << "(" << b.usage << ") < " << a.lowName << " (" << a.usage << ")";
-    */
-    return less;
+
+void FastCatalog::addItem(const CatItem& item) {
+    // Prevent other writers accessing the prepared generation
+    QMutexLocker locker(&m_mutex);
+
+    CatalogGeneration& generation = nextGeneration();
+    int slot = m_timestamp > 0 ? generation.findItem(item) : -1;
+    if (slot < 0) {
+        slot = storeItem(generation, item, slot);
+        // Slots are appended in ascending order, so the posting lists stay sorted
+        if (!generation.indexDirty) {
+            indexItem(generation, slot);
+        }
+    }
+    else {
+        const CatalogStore& store = generation.store;
+        bool sameNames = store.searchName(slot, CatItem::LOWER) == item.searchName[CatItem::LOWER]
+            && store.searchName(slot, CatItem::TRANS) == item.searchName[CatItem::TRANS];
+        storeItem(generation, item, slot);
+        // A replaced item normally keeps its search names, if a plugin changed
+        // them the posting lists are rebuilt before the generation is published
+        if (!sameNames) {
+            generation.indexDirty = true;
+        }
+    }
 }
 
-bool CatLessPtr(CatItem* a, CatItem* b) {
-    // Items with negative usage are lowest priority
-    if (a->usage < 0 && b->usage >= 0)
-        return false;
-    if (b->usage < 0 && a->usage >= 0)
-        return true;
+void FastCatalog::finishGeneration(CatalogGeneration& generation) {
+    // Build the index here on the writer's thread, searches never modify a generation
+    if (generation.indexDirty) {
+        rebuildIndex(generation);
+    }
+}
 
-    bool localEqual = (a->searchName[CatItem::LOWER] == g_searchText
-        || a->searchName[CatItem::TRANS] == g_searchText);
+// Collect the slots of the items that contain every character of text
+bool FastCatalog::findCandidates(const CatalogGeneration& generation, const QString& text,
+                                 QVector<int>& result) const {
+    // Every character of the search text has to appear in the search names
+    // of a matching item, so only items found in all posting lists are candidates
+    QVector<const QVector<int>*> lists;
+    foreach(QChar c, text) {
+        QHash<ushort, QVector<int>>::const_iterator it = generation.postings.constFind(c.unicode());
+        if (it == generation.postings.constEnd()) {
+            return true;
+        }
+        if (!lists.contains(&it.value())) {
+            lists.push_back(&it.value());
+        }
+    }
 
-    bool otherEqual = (b->searchName[CatItem::LOWER] == g_searchText
-        || b->searchName[CatItem::TRANS] == g_searchText);
+    // Intersect starting from the shortest list to keep the candidate set small
+    std::sort(lists.begin(), lists.end(),
+              [](const QVector<int>* a, const QVector<int>* b) {
+                  return a->size() < b->size();
+              });
+
+    result = *lists.first();
+    QVector<int> intersection;
+    for (int i = 1; i < lists.size() && !result.isEmpty(); ++i) {
+        intersection.clear();
+        std::set_intersection(result.constBegin(), result.constEnd(),
+                              lists[i]->constBegin(), lists[i]->constEnd(),
+                              std::back_inserter(intersection));
+        result.swap(intersection);
+    }
 
-    // Exact match between search text and item name has higest priority
-    if (localEqual && !otherEqual)
-        return true;
-    if (!localEqual && otherEqual)
-        return false;
+    // The index ignores character order, the search checks the candidates
+    return true;
+}
 
-    int localFind = std::min(a->searchName[CatItem::LOWER].indexOf(g_searchText),
-                             a->searchName[CatItem::TRANS].indexOf(g_searchText));
-    int otherFind = std::min(b->searchName[CatItem::LOWER].indexOf(g_searchText),
-                             b->searchName[CatItem::TRANS].indexOf(g_searchText));
+void FastCatalog::indexItem(CatalogGeneration& generation, int slot) {
+    // Collect the distinct characters of both search names
+    QVarLengthArray<ushort, 64> chars;
+    for (int type = CatItem::LOWER; type < CatItem::CAPACITY; ++type) {
+        SearchNameRef name = generation.store.searchName(slot, (CatItem::SearchNameType)type);
+        for (int i = 0; i < name.size(); ++i) {
+            chars.append(name.at(i));
+        }
+    }
+    std::sort(chars.begin(), chars.end());
+    ushort* last = std::unique(chars.begin(), chars.end());
 
-    if (g_searchText.count() == 1) {
-        // Match at the start
-        if (localFind == 0 && otherFind != 0)
-            return true;
-        else if (localFind != 0 && otherFind == 0)
-            return false;
+    for (ushort* c = chars.begin(); c != last; ++c) {
+        generation.postings[*c].push_back(slot);
+    }
+}
 
-        // Higher usage
-        if (a->usage > b->usage)
-            return true;
-        if (a->usage < b->usage)
-            return false;
+void FastCatalog::rebuildIndex(CatalogGeneration& generation) {
+    qDebug() << "FastCatalog::rebuildIndex, indexing" << generation.store.count() << "items";
+    generation.postings.clear();
+    for (int i = 0; i < generation.store.count(); ++i) {
+        indexItem(generation, i);
     }
+    generation.indexDirty = false;
+}
 
+CatRank::CatRank(const CatItemRef& item, const QString& text)
+    : shortName(item.shortName),
+      key(item.key) {
+    const SearchNameRef& lower = item.searchName[CatItem::LOWER];
+    const SearchNameRef& trans = item.searchName[CatItem::TRANS];
+
+    // Exact match between search text and item name has higest priority
+    bool exact = lower == text || trans == text;
     // Contiguous text anywhere in the item name
-    if (localFind != -1 && otherFind == -1)
-        return true;
-    else if (localFind == -1 && otherFind != -1)
-        return false;
+    int textFind = std::min(lower.indexOf(text), trans.indexOf(text));
+    // A single character ranks items starting with it first, then by score
+    bool singleChar = text.count() == 1;
+
+    // Items with negative usage are lowest priority,
+    // among them the least demoted ones rank first
+    demoted = item.usage < 0 ? 1 : 0;
+    float itemScore = demoted ? (float)item.usage : item.frecency;
+    inexact = exact ? 0 : 1;
+    notPrefix = singleChar && textFind != 0 ? 1 : 0;
+    prefixScore = singleChar ? -itemScore : 0;
+    notFound = textFind == -1 ? 1 : 0;
+    score = -itemScore;
+    find = textFind;
+    nameLength = item.shortName.count();
+}
 
-    if (localFind != -1 && otherFind != -1) {
-        // Both have word matches
-        // Higher usage
-        if (a->usage > b->usage)
-            return true;
-        if (a->usage < b->usage)
-            return false;
+CatRank::CatRank(const CatOrder& order, const QString& text, bool exact)
+    : key(0) {
+    // Every criterion at its best given order, with an empty short name and
+    // key 0 a rank is only less than the bound if its criteria are
+    demoted = order.demoted;
+    inexact = exact ? 0 : 1;
+    notPrefix = 0;
+    prefixScore = text.count() == 1 ? order.score : 0;
+    notFound = 0;
+    score = order.score;
+    find = 0;
+    nameLength = order.nameLength;
+}
 
-        // Contiguous text nearer the start of the item name
-        if (localFind < otherFind)
-            return true;
-        else if (otherFind < localFind)
-            return false;
-    }
-    else {
-        // Higher usage
-        if (a->usage > b->usage)
-            return true;
-        if (a->usage < b->usage)
-            return false;
+bool CatRank::operator<(const CatRank& other) const {
+    auto criteria = std::tie(demoted, inexact, notPrefix, prefixScore,
+                             notFound, score, find, nameLength);
+    auto otherCriteria = std::tie(other.demoted, other.inexact, other.notPrefix, other.prefixScore,
+                                  other.notFound, other.score, other.find, other.nameLength);
+    if (criteria != otherCriteria) {
+        return criteria < otherCriteria;
     }
 
-    int localLen = a->shortName.count();
-    int otherLen = b->shortName.count();
+    // Absolute tiebreaker to prevent loops, the key avoids building full paths
+    return std::tie(shortName, this->key) < std::tie(other.shortName, other.key);
+}
 
-    // Favour shorter item names
-    if (localLen < otherLen)
-        return true;
-    if (localLen > otherLen)
-        return false;
+CatOrder::CatOrder(int usage, float frecency, int nameLength)
+    : demoted(usage < 0 ? 1 : 0),
+      score(usage < 0 ? -(float)usage : -frecency),
+      nameLength(nameLength) {
 
-    // Absolute tiebreaker to prevent loops
-    return a->fullPath < b->fullPath;
 }
 
-CatalogItem::CatalogItem()
-    : m_timestamp(0) {
-
+bool CatOrder::operator<(const CatOrder& other) const {
+    return std::tie(demoted, score, nameLength)
+        < std::tie(other.demoted, other.score, other.nameLength);
 }
 
-CatalogItem::CatalogItem(const CatItem& item, int time)
-    : CatItem(item),
-      m_timestamp(time) {
+CatalogSearchCache::CatalogSearchCache()
+    : m_generation(-1) {
+
+}
 
+void CatalogSearchCache::clear() {
+    m_generation = -1;
+    m_queries.clear();
+    m_matches.clear();
 }
 
 }
@@ -19,51 +19,236 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <QVector>
+#include <QHash>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QFuture>
+#include <QStringList>
 #include "CatalogItem.h"
+#include "CatalogColdSegment.h"
+#include "CatalogStore.h"
+#include "FrecencyStore.h"
+#include "UsageJournal.h"
 
 // These classes do not pertain to plugins
 
 namespace launchy {
+class CatalogSearchCache;
+struct CatalogSearchShard;
+
+// CatalogGeneration is one version of the catalog items. A published
+// generation is never modified, so searches read it without locking
+// while the builder prepares the next generation on a copy.
+struct CatalogGeneration {
+    CatalogGeneration();
+
+    // Return the slot of the stored item equal to item, or -1
+    int findItem(const CatItem& item) const;
+    void rebuildSlotIndex();
+    // Move the slots into CatOrder, the order searches rely on to stop early
+    void sortSlots();
+    void rebuildLengthIndex();
+    // Approximate heap memory used by the resident items in bytes
+    qint64 memoryUsage() const;
+
+    // Identifies a published generation
+    int id;
+    CatalogStore store;
+    // Maps the identity key of every item to its slot in store
+    QHash<quint64, int> slotIndex;
+    // Posting list of item slots for every search name character, FastCatalog only
+    QHash<ushort, QVector<int>> postings;
+    bool indexDirty;
+    // Slots of the items with a search name of each length, the candidates
+    // for an exact match. Longer search names are not indexed
+    QVector<QVector<int>> lengthIndex;
+    // Items moved out of memory, none of them is in store
+    std::shared_ptr<const CatalogColdSegment> cold;
+};
+
+// Usage of an item changed since the current generation was published
+struct CatalogUsage {
+    int usage;
+    float frecency;
+};
+
+// Usage changes by identity key
+typedef QHash<quint64, CatalogUsage> CatalogUsageMap;
+
+// Sizes of the published generation and how often the cold segment is searched
+struct CatalogMemoryStats {
+    int residentCount;
+    // Approximate heap memory of the resident items in bytes
+    qint64 residentBytes;
+    int coldCount;
+    // Size of the cold segment file in bytes
+    qint64 coldBytes;
+    // Searches that reached the cold segment, and those it added results to
+    int coldSearches;
+    int coldHits;
+};
+
 // Catalog provides methods to search and manage the indexed items
 class Catalog {
 public:
     Catalog();
     virtual ~Catalog();
+    // Load the catalog in growing batches, each batch is published so searches
+    // run against the items loaded so far. Call it on the builder thread
     bool load(const QString& filename);
     bool save(const QString& filename);
+    // Save on the global thread pool, a save waiting to start is not queued twice
+    void saveInBackground(const QString& filename);
+    // Block until the last save started in the background is complete
+    void waitForSave();
+    // Block until the catalog set with setFiles is loaded
+    void waitForLoad();
     void incrementTimestamp();
-    void searchCatalogs(const QString&, QList<CatItem>&);
+    void searchCatalogs(const QString&, QList<CatItem>&, CatalogSearchCache* cache = nullptr);
     void promoteRecentlyUsedItems(const QString& text, QList<CatItem> & list);
+    // Sort items from best to worst match of the lower case search text
+    void sortItems(QList<CatItem>& items, const QString& text);
+
+    // Usage changes are appended to the journal as they happen and replayed
+    // by load, save writes them to the catalog and the launch history.
+    // The files should be set before the catalog is loaded, background saves
+    // and cold segments are written to catalogFilename. Saves are refused
+    // from the first call until the first load finished
+    void setFiles(const QString& catalogFilename, const QString& frecencyFilename,
+                  const QString& journalFilename);
+
+    // Start preparing the next generation on a copy of the current one,
+    // changes are invisible to searches until commitUpdate publishes them
+    void beginUpdate();
+    void commitUpdate();
+    // Drop the prepared generation, searches keep using the current one
+    void abortUpdate();
 
-    virtual int count() = 0;
+    int count();
+    CatalogMemoryStats memoryStats() const;
+    // Return true if every key is the identity key of an item of the
+    // published catalog, resident or cold
+    bool containsItems(const QVector<quint64>& keys) const;
+    void incrementUsage(const CatItem& item);
+    void demoteItem(const CatItem& item);
+
+    // These methods change the prepared generation,
+    // an update is started if none is running
     virtual void clear() = 0;
+    virtual void reserve(int count) = 0;
     virtual void addItem(const CatItem& item) = 0;
-    virtual void purgeOldItems() = 0;
-
-    virtual void incrementUsage(const CatItem& item) = 0;
-    virtual void demoteItem(const CatItem& item) = 0;
+    // Remove the items not added since the timestamp was incremented, return their number
+    virtual int purgeOldItems() = 0;
+    // Remove the resident items with keys, return their number
+    virtual int removeItems(const QVector<quint64>& keys) = 0;
+    // Keep the items with keys as if they were added again unchanged,
+    // return the number of keys found
+    int touchItems(const QVector<quint64>& keys);
 
     static bool matches(CatItem* item, const QString& match);
+    // 64-bit identity key of an item, hashed from its fullPath and shortName
+    static quint64 itemKey(const CatItem& item);
     static QString decorateText(const QString& text, const QString& match, bool outputRichText = false);
 
 protected:
-    virtual const CatItem& getItem(int) = 0;
-    virtual QList<CatItem*> search(const QString&) = 0;
+    // Add the items [begin, end) of a binary catalog file, the earlier items are already added
+    virtual void loadItems(const CatalogFile& file, int begin, int end);
+    // Complete the prepared generation before it is published
+    virtual void finishGeneration(CatalogGeneration& generation);
+    // Store the slots of generation that may match the lower case search text
+    // in result, return false if every slot has to be checked
+    virtual bool findCandidates(const CatalogGeneration& generation, const QString& text,
+                                QVector<int>& result) const;
 
+    // Return the prepared generation, copying the current one if no update is running
+    // this method should only be called from within a QMutexLocker protected section
+    CatalogGeneration& nextGeneration();
+
+private:
+    bool loadLegacy(const QString& filename);
+    // Apply the records to the usage counts and to the launch history, as selected
+    void replayJournal(const QVector<UsageJournalRecord>& records, bool usage, bool frecency);
+    // this method should only be called from within a m_usageMutex protected section
+    void scheduleSave(const QString& filename);
+    void updateUsage(const CatItem& item, bool demote);
+    // Apply a launch or demotion of the item with key at slot, or -1 if it is not in the catalog
+    // this method should only be called from within a m_usageMutex protected section
+    void applyUsage(const CatalogGeneration& generation, CatalogUsageMap& usage,
+                    quint64 key, int slot, int itemUsage, bool demote, qint64 time);
+    // Move the lowest scored items of generation to a new cold segment
+    // until the resident items fit in the memory budget
+    void enforceBudget(CatalogGeneration& generation);
+    // Append the items of the cold segment matching the lower case text to found
+    void searchColdSegment(const CatalogGeneration& generation, const CatalogUsageMap& usage,
+                           const QString& text, QList<CatItem>& found);
+    void searchShard(CatalogSearchShard& shard, const CatalogGeneration& generation,
+                     const CatalogUsageMap& usage, const QString& text,
+                     const QVector<int>* domain, bool domainMatches,
+                     const QVector<int>& pinned, int numResults);
+    // Keep the count best ranked slots for text in rank order
+    static void selectTopItems(const CatalogGeneration& generation, const CatalogUsageMap& usage,
+                               QVector<int>& slots, const QString& text, int count);
+    static CatItem getItem(const CatalogGeneration& generation, const CatalogUsageMap& usage,
+                           int slot);
+    static CatItemRef itemRef(const CatalogGeneration& generation, const CatalogUsageMap& usage,
+                              int slot);
+
+protected:
     int m_timestamp;
+    // Serializes the changes to the prepared generation, searches never take it
     QMutex m_mutex;
+
+private:
+    // Only accessed with std::atomic_load and std::atomic_store
+    std::shared_ptr<const CatalogGeneration> m_current;
+    std::shared_ptr<const CatalogUsageMap> m_usage;
+    std::shared_ptr<CatalogGeneration> m_next;
+    // Serializes usage changes and publishing a generation,
+    // guards the launch history and the journal
+    QMutex m_usageMutex;
+    FrecencyStore m_frecency;
+    UsageJournal m_journal;
+    QString m_frecencyFilename;
+    QString m_journalFilename;
+    // The catalog file, background saves write it and cold segments are stored next to it
+    QString m_filename;
+    // Set while a background save is waiting to start
+    bool m_savePending;
+    QFuture<bool> m_saveFuture;
+    int m_lastId;
+    // Serializes saving, a background save may run at any time
+    QMutex m_saveMutex;
+    // Set while load has not published all the items yet
+    std::atomic<bool> m_loading;
+    // Set from setFiles until the first load finished, saving before would
+    // write the empty catalog over the file. Both are guarded by m_usageMutex
+    bool m_loadExpected;
+    bool m_loaded;
+    QWaitCondition m_loadFinished;
+    // Numbers the cold segment files, guarded by m_mutex
+    int m_coldSerial;
+    // Searches that reached the cold segment and those it added results to
+    std::atomic<int> m_coldSearches;
+    std::atomic<int> m_coldHits;
 };
 
 
-// CatalogItem is used internally to store additional
-class CatalogItem : public CatItem {
+// CatalogSearchCache keeps the slots matched by the previous queries,
+// each query in the cache is a prefix of the next one. A query that extends
+// a cached query only has to check the slots that query matched.
+class CatalogSearchCache {
 public:
-    CatalogItem();
-    CatalogItem(const CatItem& item, int time);
+    CatalogSearchCache();
+    void clear();
 
-    int m_timestamp;
+private:
+    friend class Catalog;
+    int m_generation;
+    QStringList m_queries;
+    QList<QVector<int>> m_matches;
 };
 
 
@@ -74,23 +259,75 @@ public:
 class SlowCatalog : public Catalog {
 public:
     SlowCatalog() : Catalog() {}
-    virtual int count();
     virtual void clear();
+    virtual void reserve(int count);
     virtual void addItem(const CatItem& item);
-    virtual void purgeOldItems();
+    virtual int purgeOldItems();
+    virtual int removeItems(const QVector<quint64>& keys);
 
-    virtual void incrementUsage(const CatItem& item);
-    virtual void demoteItem(const CatItem& item);
+protected:
+    virtual void loadItems(const CatalogFile& file, int begin, int end);
+
+    // Store item at slot, or append it when slot is -1, and return its slot
+    // this method should only be called from within a QMutexLocker protected section
+    int storeItem(CatalogGeneration& generation, const CatItem& item, int slot);
+};
+
+
+/** This class does not pertain to plugins */
+// The fast catalog keeps a posting list of item slots for every character
+// found in the search names, a search only visits the items that contain
+// all the characters of the search text
+class FastCatalog : public SlowCatalog {
+public:
+    FastCatalog() : SlowCatalog() {}
+    virtual void addItem(const CatItem& item);
 
 protected:
-    virtual const CatItem& getItem(int i);
-    virtual QList<CatItem*> search(const QString& searchText);
+    virtual void finishGeneration(CatalogGeneration& generation);
+    virtual bool findCandidates(const CatalogGeneration& generation, const QString& text,
+                                QVector<int>& result) const;
 
 private:
-    QVector<CatalogItem> m_catalogItems;
+    static void indexItem(CatalogGeneration& generation, int slot);
+    static void rebuildIndex(CatalogGeneration& generation);
+};
+
+// CatOrder holds the ranking criteria of an item that do not depend on
+// the search text, in the same priority as CatRank
+struct CatOrder {
+    CatOrder(int usage, float frecency, int nameLength);
+    bool operator<(const CatOrder& other) const;
+
+    int demoted;
+    // Negated frecency, or negated usage of demoted items
+    float score;
+    int nameLength;
 };
 
-bool CatLessPtr(CatItem* left, CatItem* right);
-bool CatLessRef(CatItem& left, CatItem& right);
+// CatRank holds the ranking criteria of an item for a search text,
+// they are computed once per item instead of on every comparison
+struct CatRank {
+    CatRank(const CatItemRef& item, const QString& text);
+    // The best rank an item at or after order can have for text,
+    // exact is false when none of those items can match text exactly
+    CatRank(const CatOrder& order, const QString& text, bool exact);
+    bool operator<(const CatRank& other) const;
+
+    // Criteria in order of priority, lower values rank first
+    int demoted;
+    int inexact;
+    int notPrefix;
+    // Negated score, only used for single character search texts
+    float prefixScore;
+    int notFound;
+    // Negated frecency, or negated usage of demoted items
+    float score;
+    // Position of the search text in the search names, or -1
+    int find;
+    int nameLength;
+    QStringRef shortName;
+    quint64 key;
+};
 
 }
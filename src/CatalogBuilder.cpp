@@ -18,11 +18,14 @@
 */
 
 #include "CatalogBuilder.h"
+#include <algorithm>
+#include <QElapsedTimer>
 #include <QThread>
 #include "Catalog.h"
 #include "AppBase.h"
 #include "Directory.h"
 #include "SettingsManager.h"
+#include "OptionItem.h"
 
 #define CATALOG_PROGRESS_MIN 0
 #define CATALOG_PROGRESS_MAX 100
@@ -32,136 +35,275 @@ namespace launchy {
 CatalogBuilder* CatalogBuilder::s_instance = nullptr;
 
 CatalogBuilder::CatalogBuilder()
-    : m_catalog(new SlowCatalog),
+    : m_catalog(nullptr),
       m_thread(new QThread),
+      m_manifestLoaded(false),
+      m_watching(false),
       m_progress(CATALOG_PROGRESS_MAX) {
+    if (g_settings->value(OPTION_FASTCATALOG, OPTION_FASTCATALOG_DEFAULT).toBool()) {
+        m_catalog = new FastCatalog;
+    }
+    else {
+        m_catalog = new SlowCatalog;
+    }
     moveToThread(m_thread);
     m_thread->start(QThread::IdlePriority);
 }
 
-void CatalogBuilder::buildCatalog() {
+void CatalogBuilder::loadCatalog() {
+    // Searches use the items published so far while the rest is loading
+    bool loaded = m_catalog->load(SettingsManager::instance().catalogFilename());
+    if (loaded) {
+        // Watch the directories the last rebuild recorded, a rebuild is
+        // not needed to pick up the changes made from now on
+        if (!m_manifestLoaded) {
+            m_manifest.load(SettingsManager::instance().manifestFilename());
+            m_manifestLoaded = true;
+        }
+        updateWatcher(catalogDirectories());
+    }
+    emit catalogLoaded(loaded);
+}
+
+void CatalogBuilder::buildCatalog(bool full) {
     m_progress = CATALOG_PROGRESS_MIN;
     emit catalogIncrement(m_progress);
     m_catalog->incrementTimestamp();
+    // Searches keep using the current catalog until the rebuilt one is committed
+    m_catalog->beginUpdate();
     m_indexed.clear();
 
     PluginHandler& pluginHandler = PluginHandler::instance();
-    QList<Directory> memDirs = SettingsManager::instance().readCatalogDirectories();
+    QList<Directory> memDirs = catalogDirectories();
     const QHash<uint, PluginInfo>& pluginsInfo = pluginHandler.getPlugins();
     m_totalItems = memDirs.count() + pluginsInfo.count();
     m_currentItem = 0;
 
-    while (m_currentItem < memDirs.count()) {
-        QString currentDir = g_app->expandEnvironmentVars(memDirs[m_currentItem].name);
-        indexDirectory(currentDir,
-                       memDirs[m_currentItem].types,
-                       memDirs[m_currentItem].indexDirs,
-                       memDirs[m_currentItem].indexExe,
-                       memDirs[m_currentItem].depth);
-        progressStep(m_currentItem);
+    if (full) {
+        // Files edited in place and settings the manifest does not record
+        // are only picked up by reading everything again
+        m_manifest.clear();
+        m_manifestLoaded = true;
+    }
+    else if (!m_manifestLoaded) {
+        m_manifest.load(SettingsManager::instance().manifestFilename());
+        m_manifestLoaded = true;
     }
+    DirectoryManifest manifest;
+    indexDirectories(memDirs, manifest, false);
 
     // Don't call the pluginhandler to request catalog because we need to track progress
     pluginHandler.getCatalogs(m_catalog, this);
 
-    m_catalog->purgeOldItems();
+    QElapsedTimer purgeTimer;
+    purgeTimer.start();
+    int purged = m_catalog->purgeOldItems();
+    int purgeTime = (int)purgeTimer.elapsed();
+    qDebug() << "CatalogBuilder::buildCatalog, purged" << purged << "items in" << purgeTime << "ms";
+    emit catalogPurged(purged, purgeTime);
+    m_catalog->commitUpdate();
     m_indexed.clear();
+    m_manifest = manifest;
+    m_manifest.save(SettingsManager::instance().manifestFilename());
+    updateWatcher(memDirs);
+
     m_progress = CATALOG_PROGRESS_MAX;
     emit catalogFinished();
 }
 
-void CatalogBuilder::indexDirectory(const QString& directory,
-                                    const QStringList& filters,
-                                    bool fdirs,
-                                    bool fbin,
-                                    int depth) {
-    QString dir = QDir::toNativeSeparators(directory);
-    QDir qDir(dir);
-    dir = qDir.absolutePath();
-    QStringList dirs = qDir.entryList(QDir::Dirs|QDir::NoDotAndDotDot);
-
-    if (depth > 0) {
-        for (int i = 0; i < dirs.count(); ++i) {
-            if (!dirs[i].startsWith(".")) {
-                QString cur = dirs[i];
-                if (!cur.contains(".lnk")) {
-#ifdef Q_OS_MAC
-                    // Special handling of app directories
-                    if (cur.endsWith(".app", Qt::CaseInsensitive)) {
-                        CatItem item(dir + "/" + cur);
-                        g_app->alterItem(&item);
-                        g_catalog->addItem(item);
-                    }
-                    else
-#endif
-                        indexDirectory(dir + "/" + dirs[i], filters, fdirs, fbin, depth-1);
-                }
+void CatalogBuilder::updateDirectories(const QStringList& paths) {
+    // Each changed directory is walked again like a catalog directory of its
+    // own, with the settings and the depth left of the one it belongs to
+    QList<Directory> memDirs = catalogDirectories();
+    QList<Directory> targets;
+    foreach(const QString& path, paths) {
+        foreach(const Directory& root, memDirs) {
+            int level = DirectoryManifest::levelBelow(
+                QDir(QDir::toNativeSeparators(root.name)).absolutePath(), path);
+            if (level >= 0 && level <= root.depth) {
+                Directory target = root;
+                target.name = path;
+                target.depth = root.depth - level;
+                targets.push_back(target);
+                break;
             }
         }
     }
 
-    if (fdirs) {
-        for (int i = 0; i < dirs.count(); ++i) {
-            if (!dirs[i].startsWith(".") && !m_indexed.contains(dir + "/" + dirs[i])) {
-                bool isShortcut = dirs[i].endsWith(".lnk", Qt::CaseInsensitive);
-
-                CatItem item(dir + "/" + dirs[i], !isShortcut);
-                m_catalog->addItem(item);
-                m_indexed.insert(dir + "/" + dirs[i]);
+    // Directories below another changed directory are walked with it,
+    // sorting puts every directory after the directories above it
+    std::sort(targets.begin(), targets.end(), [](const Directory& a, const Directory& b) {
+        return a.name < b.name;
+    });
+    QList<Directory> dirs;
+    foreach(const Directory& target, targets) {
+        bool covered = false;
+        foreach(const Directory& dir, dirs) {
+            int level = DirectoryManifest::levelBelow(dir.name, target.name);
+            if (level >= 0 && level <= dir.depth) {
+                covered = true;
+                break;
             }
         }
-    }
-    else {
-        // Grab any shortcut directories
-        // This is to work around a QT weirdness that treats shortcuts to directories as actual directories
-        for (int i = 0; i < dirs.count(); ++i) {
-            if (!dirs[i].startsWith(".")
-                && dirs[i].endsWith(".lnk", Qt::CaseInsensitive)) {
-                if (!m_indexed.contains(dir + "/" + dirs[i])) {
-                    CatItem item(dir + "/" + dirs[i], true);
-                    m_catalog->addItem(item);
-                    m_indexed.insert(dir + "/" + dirs[i]);
-                }
-            }
+        if (!covered) {
+            dirs.push_back(target);
         }
     }
+    if (dirs.isEmpty()) {
+        return;
+    }
 
-    if (fbin) {
-        QStringList bins = qDir.entryList(QDir::Files | QDir::Executable);
-        for (int i = 0; i < bins.count(); ++i) {
-            if (!m_indexed.contains(dir + "/" + bins[i])) {
-                CatItem item(dir + "/" + bins[i]);
-                m_catalog->addItem(item);
-                m_indexed.insert(dir + "/" + bins[i]);
-            }
+    QElapsedTimer updateTimer;
+    updateTimer.start();
+    m_catalog->beginUpdate();
+    m_indexed.clear();
+    DirectoryManifest manifest;
+    int changed = indexDirectories(dirs, manifest, true);
+
+    // Remove the items that were not found again,
+    // of the entries and the directories that are gone
+    QVector<quint64> previousKeys;
+    foreach(const Directory& dir, dirs) {
+        m_manifest.takeTree(dir.name, dir.depth, previousKeys);
+    }
+    QSet<quint64> keys;
+    foreach(const QString& path, manifest.paths()) {
+        const DirectoryManifestEntry* entry = manifest.find(path);
+        foreach(const DirectoryManifestItem& item, entry->items) {
+            keys.insert(item.key);
+        }
+        m_manifest.insert(path, *entry);
+    }
+    QVector<quint64> removedKeys;
+    foreach(quint64 key, previousKeys) {
+        if (!keys.contains(key)) {
+            removedKeys.push_back(key);
         }
     }
+    int removed = m_catalog->removeItems(removedKeys);
+    m_indexed.clear();
+    // New directories are watched as well
+    if (m_watcher) {
+        m_watcher->watch(memDirs, m_manifest);
+    }
 
-    // Don't want a null file filter, that matches everything..
-    if (filters.empty()) {
+    // The directories changed without changing their items, like a hidden file
+    // that was written, the catalog and the saved manifest stay as they are
+    if (changed == 0 && removed == 0) {
+        m_catalog->abortUpdate();
+        qDebug() << "CatalogBuilder::updateDirectories, no items changed in" << dirs.count()
+                 << "directories in" << updateTimer.elapsed() << "ms";
         return;
     }
 
-    QStringList files = qDir.entryList(filters, QDir::Files | QDir::System, QDir::Unsorted);
-    for (int i = 0; i < files.count(); ++i) {
-        if (!m_indexed.contains(dir + "/" + files[i])) {
-            CatItem item(dir + "/" + files[i]);
+    m_catalog->commitUpdate();
+    m_manifest.save(SettingsManager::instance().manifestFilename());
+    qDebug() << "CatalogBuilder::updateDirectories, updated" << dirs.count() << "directories,"
+             << changed << "items changed," << removed << "removed, in"
+             << updateTimer.elapsed() << "ms";
+    emit catalogUpdated();
+}
+
+QList<Directory> CatalogBuilder::catalogDirectories() const {
+    QList<Directory> dirs = SettingsManager::instance().readCatalogDirectories();
+    for (int i = 0; i < dirs.count(); ++i) {
+        dirs[i].name = g_app->expandEnvironmentVars(dirs[i].name);
+    }
+    return dirs;
+}
+
+int CatalogBuilder::indexDirectories(const QList<Directory>& dirs, DirectoryManifest& manifest,
+                                     bool changed) {
+    // The directories are walked in parallel, their items are added directory
+    // by directory in the configured order while the rest is still walked
+    QElapsedTimer indexTimer;
+    indexTimer.start();
+    DirectoryIndexer indexer(dirs,
+                             g_settings->value(OPTION_INDEXTHREADS, OPTION_INDEXTHREADS_DEFAULT).toInt(),
+                             &m_manifest, m_catalog);
+    indexer.setListRoots(changed);
+    indexer.start();
+    g_app->beginAlterItems();
+    int changedItems = 0;
+    for (int i = 0; i < dirs.count(); ++i) {
+        QVector<DirectoryIndexer::Listing> listings = indexer.takeListings(i);
+        for (int j = 0; j < listings.count(); ++j) {
+            changedItems += addListing(listings[j]);
+            manifest.insert(listings[j].path, listings[j].entry);
+        }
+        // Updates of changed directories are not shown as progress
+        if (!changed) {
+            progressStep(m_currentItem);
+        }
+    }
+    qDebug() << "CatalogBuilder::indexDirectories, walked" << indexer.directoryCount()
+        << "directories," << indexer.unchangedCount() << "unchanged, in"
+        << indexTimer.elapsed() << "ms";
+    return changedItems;
+}
+
+void CatalogBuilder::updateWatcher(const QList<Directory>& dirs) {
+    if (g_settings->value(OPTION_WATCHDIRECTORIES, OPTION_WATCHDIRECTORIES_DEFAULT).toBool()) {
+        if (!m_watcher) {
+            m_watcher.reset(new DirectoryWatcher([this](const QStringList& paths) {
+                updateDirectories(paths);
+            }));
+        }
+        m_watcher->watch(dirs, m_manifest);
+    }
+    else {
+        m_watcher.reset();
+    }
+    m_watching = m_watcher && (m_watcher->watchCount() > 0 || m_watcher->polledCount() > 0);
+}
+
+int CatalogBuilder::addListing(DirectoryIndexer::Listing& listing) {
+    if (m_catalog->touchItems(listing.reused) < listing.reused.count()) {
+        // An item left the catalog since the indexer found it, list the directory next time
+        listing.entry.mtime = -1;
+    }
+
+    int changed = 0;
+    for (int i = 0; i < listing.items.count(); ++i) {
+        DirectoryIndexer::Item& staged = listing.items[i];
+        DirectoryManifestItem& record = listing.entry.items[staged.record];
+        CatItem& item = staged.item;
+        QString path = item.fullPath;
+        if (m_indexed.contains(path)) {
+            // Another directory added the item, check it again next time
+            record.mtime = -1;
+            continue;
+        }
+
+        // The platform caches used to alter items are not thread safe,
+        // so the indexer leaves this to the builder thread
+        if (staged.alter) {
             g_app->alterItem(&item);
 #ifdef Q_OS_LINUX
             if (item.fullPath.endsWith(".desktop") && item.iconPath == "")
                 continue;
 #endif
-            m_catalog->addItem(item);
-
-            m_indexed.insert(dir + "/" + files[i]);
         }
+        record.key = Catalog::itemKey(item);
+        // An item found again as it is changes nothing, the altered
+        // ones were staged because their file is new or was modified
+        if (staged.alter || !m_catalog->containsItems(QVector<quint64>(1, record.key))) {
+            ++changed;
+        }
+        m_catalog->addItem(item);
+        m_indexed.insert(path);
     }
+    return changed;
 }
 
 CatalogBuilder::~CatalogBuilder() {
     s_instance = nullptr;
     qDebug() << "CatalogBuilder::~CatalogBuilder, exit thread";
     if (m_thread) {
+        // The watcher's notifier and timers belong to the builder thread
+        QMetaObject::invokeMethod(this, [this]() {
+            m_watcher.reset();
+        }, Qt::BlockingQueuedConnection);
         m_thread->exit();
         m_thread->wait();
         m_thread->deleteLater();
@@ -200,6 +342,10 @@ int CatalogBuilder::isRunning() const {
     return m_progress < CATALOG_PROGRESS_MAX;
 }
 
+bool CatalogBuilder::isWatching() const {
+    return m_watching;
+}
+
 bool CatalogBuilder::progressStep(int newStep) {
     newStep = newStep;
 
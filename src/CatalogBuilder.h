@@ -19,8 +19,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <QObject>
 #include "PluginHandler.h"
+#include "DirectoryIndexer.h"
+#include "DirectoryWatcher.h"
 class QThread;
 
 namespace launchy {
@@ -34,18 +38,42 @@ public:
 
     int getProgress() const;
     int isRunning() const;
+    // True while changes in the catalog directories are watched or polled
+    bool isWatching() const;
     virtual bool progressStep(int newStep);
 
 public slots:
-    void buildCatalog();
+    void loadCatalog();
+    // A full rebuild lists every directory and alters every item again,
+    // otherwise the directories unchanged since the last rebuild are skipped
+    void buildCatalog(bool full);
+    // Walk the changed directories again and update their items in place
+    void updateDirectories(const QStringList& paths);
 
 signals:
+    void catalogLoaded(bool);
     void catalogIncrement(int);
+    // Number of items removed by the rebuild and the time it took in milliseconds
+    void catalogPurged(int, int);
     void catalogFinished();
+    // The items of changed directories were updated
+    void catalogUpdated();
 
 private:
-    void indexDirectory(const QString& dir, const QStringList& filters,
-                        bool fdirs, bool fbin, int depth);
+    // The catalog directories with their names expanded
+    QList<Directory> catalogDirectories() const;
+    // Walk dirs with the directory indexer, add their items and record them
+    // in manifest. Changed directories are listed even if their modification
+    // time is the same, files may have been modified in place.
+    // Return the number of items that are new or may have changed
+    int indexDirectories(const QList<Directory>& dirs, DirectoryManifest& manifest, bool changed);
+    // Add the items of a directory walked by the directory indexer and
+    // complete its manifest entry, return the number of items that are
+    // not in the published catalog or were altered again
+    int addListing(DirectoryIndexer::Listing& listing);
+    // Start or stop watching the directories of the manifest in dirs,
+    // as the settings ask
+    void updateWatcher(const QList<Directory>& dirs);
 private:
     CatalogBuilder();
     Q_DISABLE_COPY(CatalogBuilder)
@@ -56,6 +84,12 @@ private:
     QThread* m_thread;
 
     QSet<QString> m_indexed;
+    // Directories recorded by the last rebuild
+    DirectoryManifest m_manifest;
+    bool m_manifestLoaded;
+    // Created on the builder thread once the catalog is loaded or rebuilt
+    std::unique_ptr<DirectoryWatcher> m_watcher;
+    std::atomic<bool> m_watching;
     int m_progress;
     int m_currentItem;
     int m_totalItems;
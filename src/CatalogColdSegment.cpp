@@ -0,0 +1,130 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "CatalogColdSegment.h"
+#include <algorithm>
+#include "CatalogStore.h"
+#include "SearchName.h"
+#include "SubsequenceMatch.h"
+
+namespace launchy {
+
+CatalogColdSegment::CatalogColdSegment() {
+
+}
+
+CatalogColdSegment::~CatalogColdSegment() {
+    m_file.close();
+    if (!m_filename.isEmpty()) {
+        QFile::remove(m_filename);
+    }
+}
+
+bool CatalogColdSegment::open(const QString& filename) {
+    m_filename = filename;
+    if (!m_file.open(filename)) {
+        qWarning() << "CatalogColdSegment::open, Could not open" << filename;
+        return false;
+    }
+
+    // Keys are hashed straight from the mapped strings
+    const QChar* strings = reinterpret_cast<const QChar*>(m_file.strings());
+    m_keys.resize(m_file.count());
+    m_order.resize(m_file.count());
+    for (int i = 0; i < m_file.count(); ++i) {
+        const CatalogFileRecord& rec = m_file.record(i);
+        QString fullPath = QString::fromRawData(strings + rec.fullPath.offset, rec.fullPath.length);
+        QString shortName = QString::fromRawData(strings + rec.shortName.offset, rec.shortName.length);
+        m_keys[i] = CatalogStore::makeKey(QStringRef(&fullPath), QStringRef(&shortName));
+        m_order[i] = i;
+    }
+    std::sort(m_order.begin(), m_order.end(),
+              [this](int a, int b) {
+                  return m_keys.at(a) < m_keys.at(b);
+              });
+    return true;
+}
+
+int CatalogColdSegment::count() const {
+    return m_file.count();
+}
+
+qint64 CatalogColdSegment::size() const {
+    return QFileInfo(m_filename).size();
+}
+
+int CatalogColdSegment::find(quint64 key) const {
+    QVector<int>::const_iterator it
+        = std::lower_bound(m_order.constBegin(), m_order.constEnd(), key,
+                           [this](int index, quint64 value) {
+                               return m_keys.at(index) < value;
+                           });
+    if (it == m_order.constEnd() || m_keys.at(*it) != key) {
+        return -1;
+    }
+    return *it;
+}
+
+quint64 CatalogColdSegment::key(int index) const {
+    return m_keys.at(index);
+}
+
+int CatalogColdSegment::usage(int index) const {
+    return m_file.record(index).usage;
+}
+
+CatItem CatalogColdSegment::item(int index) const {
+    return m_file.item(index);
+}
+
+bool CatalogColdSegment::matches(int index, const QString& text) const {
+    const CatalogFileRecord& rec = m_file.record(index);
+    const QChar* name = reinterpret_cast<const QChar*>(m_file.strings()) + rec.shortName.offset;
+    int length = rec.shortName.length;
+    int textLength = text.size();
+
+    if (isAscii(name, length)) {
+        // The search names are the lower case short name twice,
+        // the case is folded while matching instead of storing them
+        const ushort* match = text.utf16();
+        int curChar = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (int i = 0; i < length && curChar < textLength; ++i) {
+                ushort c = name[i].unicode();
+                c += (ushort)(c - 'A') < 26 ? 'a' - 'A' : 0;
+                if (c == match[curChar]) {
+                    ++curChar;
+                }
+            }
+        }
+        return curChar >= textLength;
+    }
+
+    QString lower;
+    QString trans;
+    makeSearchNames(QString::fromRawData(name, length), lower, trans);
+    int curChar = subsequenceMatch(lower.constData(), lower.size(), text.constData(), textLength);
+    if (curChar < textLength) {
+        curChar += subsequenceMatch(trans.constData(), trans.size(),
+                                    text.constData() + curChar, textLength - curChar);
+    }
+    return curChar >= textLength;
+}
+
+}
@@ -0,0 +1,63 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include "CatalogFile.h"
+
+namespace launchy {
+
+// CatalogColdSegment holds the catalog items that were moved out of memory
+// to keep the catalog within its memory budget. The items are written to a
+// binary catalog file which is mapped, so the system only keeps the pages
+// that are read in memory and can drop them again at any time. The file
+// belongs to the segment and is removed with it. A segment is never
+// appended to, every eviction writes a new one with all the cold items.
+class CatalogColdSegment {
+public:
+    CatalogColdSegment();
+    ~CatalogColdSegment();
+
+    // Map a catalog file written for the segment
+    bool open(const QString& filename);
+
+    int count() const;
+    // Size of the file in bytes
+    qint64 size() const;
+    // Return the index of the item with key, or -1
+    int find(quint64 key) const;
+    quint64 key(int index) const;
+    int usage(int index) const;
+    CatItem item(int index) const;
+    // Return true if the search names of the item at index contain the
+    // lower case text as a subsequence, see CatalogStore::matches
+    bool matches(int index, const QString& text) const;
+
+private:
+    QString m_filename;
+    CatalogFile m_file;
+    // Identity keys by index, and the indexes in key order for find
+    QVector<quint64> m_keys;
+    QVector<int> m_order;
+
+    Q_DISABLE_COPY(CatalogColdSegment)
+};
+
+}
@@ -0,0 +1,293 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "CatalogFile.h"
+
+namespace launchy {
+
+Q_STATIC_ASSERT(sizeof(CatalogFileHeader) == 40);
+Q_STATIC_ASSERT(sizeof(CatalogFileRecord) == 32);
+
+// Size of the header written by version 1
+static const quint32 HEADER_SIZE_V1 = 32;
+
+// Record written by versions 1 and 2, with the search names
+struct CatalogFileRecordV2 {
+    CatalogFileString fullPath;
+    CatalogFileString shortName;
+    CatalogFileString searchName[CatItem::CAPACITY];
+    CatalogFileString iconPath;
+    qint32 usage;
+    quint32 pluginId;
+};
+
+Q_STATIC_ASSERT(sizeof(CatalogFileRecordV2) == 48);
+
+// "LCAT" when read as a little endian integer
+const quint32 CatalogFile::MAGIC = 0x5441434c;
+const quint32 CatalogFile::VERSION = 3;
+
+struct Crc32Table {
+    Crc32Table() {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+            }
+            values[i] = crc;
+        }
+    }
+
+    quint32 values[256];
+};
+
+// Continue the CRC-32 crc over size bytes at data, start with 0
+static quint32 updateCrc32(quint32 crc, const void* data, qint64 size) {
+    static const Crc32Table table;
+    const uchar* bytes = static_cast<const uchar*>(data);
+    crc = ~crc;
+    for (qint64 i = 0; i < size; ++i) {
+        crc = table.values[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+CatalogFile::CatalogFile()
+    : m_data(nullptr),
+      m_header(nullptr),
+      m_records(nullptr),
+      m_strings(nullptr) {
+
+}
+
+CatalogFile::~CatalogFile() {
+    close();
+}
+
+bool CatalogFile::open(const QString& filename) {
+    close();
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qint64 fileSize = m_file.size();
+    if (fileSize < (qint64)HEADER_SIZE_V1) {
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, fileSize);
+    if (!m_data) {
+        qWarning() << "CatalogFile::open, could not map" << filename << m_file.errorString();
+        close();
+        return false;
+    }
+
+    m_header = reinterpret_cast<const CatalogFileHeader*>(m_data);
+    if (!validate(fileSize)) {
+        close();
+        return false;
+    }
+
+    m_records = reinterpret_cast<const CatalogFileRecord*>(m_data + m_header->recordsOffset);
+    m_strings = reinterpret_cast<const ushort*>(m_data + m_header->stringsOffset);
+    if (m_header->version < 3) {
+        convertRecords();
+    }
+    return true;
+}
+
+void CatalogFile::close() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+    m_file.close();
+    m_data = nullptr;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_strings = nullptr;
+    m_convertedRecords.clear();
+}
+
+int CatalogFile::count() const {
+    return m_header ? (int)m_header->itemCount : 0;
+}
+
+quint32 CatalogFile::journalFingerprint() const {
+    return m_header && m_header->version >= 2 ? m_header->journalFingerprint : 0;
+}
+
+const CatalogFileRecord& CatalogFile::record(int index) const {
+    return m_records[index];
+}
+
+const ushort* CatalogFile::strings() const {
+    return m_strings;
+}
+
+QString CatalogFile::string(const CatalogFileString& str) const {
+    return QString(reinterpret_cast<const QChar*>(m_strings + str.offset), str.length);
+}
+
+CatItem CatalogFile::item(int index) const {
+    const CatalogFileRecord& rec = m_records[index];
+    // The constructor derives the search names from the short name
+    CatItem item(string(rec.fullPath), string(rec.shortName), rec.pluginId, string(rec.iconPath));
+    item.usage = rec.usage;
+    return item;
+}
+
+// Check that the header and every string reference stay inside the file,
+// so that the records can be read without further bounds checks
+bool CatalogFile::validate(qint64 fileSize) const {
+    if (m_header->magic != MAGIC) {
+        return false;
+    }
+
+    quint32 recordSize = m_header->version >= 3
+        ? sizeof(CatalogFileRecord) : sizeof(CatalogFileRecordV2);
+    if (m_header->version < 1 || m_header->version > VERSION
+        || m_header->recordSize != recordSize) {
+        qWarning() << "CatalogFile::validate, unsupported version" << m_header->version;
+        return false;
+    }
+
+    // Version 1 files are still read, they are rewritten with a checksum on the next save
+    quint32 headerSize = m_header->version >= 2 ? sizeof(CatalogFileHeader) : HEADER_SIZE_V1;
+
+    quint64 recordsEnd = (quint64)m_header->recordsOffset
+        + (quint64)m_header->itemCount * recordSize;
+    quint64 stringsEnd = (quint64)m_header->stringsOffset
+        + (quint64)m_header->stringsLength * sizeof(ushort);
+    if (m_header->recordsOffset < headerSize
+        || (quint64)headerSize > (quint64)fileSize
+        || m_header->recordsOffset % sizeof(quint32) != 0
+        || m_header->stringsOffset % sizeof(ushort) != 0
+        || (quint64)m_header->stringsOffset < recordsEnd
+        || recordsEnd > (quint64)fileSize
+        || stringsEnd > (quint64)fileSize) {
+        qWarning("CatalogFile::validate, corrupted header");
+        return false;
+    }
+
+    // A catalog written only partially, or damaged later, fails the checksum
+    if (m_header->version >= 2
+        && updateCrc32(0, m_data + m_header->recordsOffset, stringsEnd - m_header->recordsOffset)
+            != m_header->checksum) {
+        qWarning("CatalogFile::validate, checksum mismatch");
+        return false;
+    }
+
+    // The strings of both layouts start with fullPath and shortName
+    const uchar* records = m_data + m_header->recordsOffset;
+    for (quint32 i = 0; i < m_header->itemCount; ++i) {
+        const uchar* rec = records + i * recordSize;
+        const CatalogFileString* strs[] = {
+            &reinterpret_cast<const CatalogFileRecord*>(rec)->fullPath,
+            &reinterpret_cast<const CatalogFileRecord*>(rec)->shortName,
+            m_header->version >= 3
+                ? &reinterpret_cast<const CatalogFileRecord*>(rec)->iconPath
+                : &reinterpret_cast<const CatalogFileRecordV2*>(rec)->iconPath
+        };
+        for (const CatalogFileString* str : strs) {
+            if ((quint64)str->offset + str->length > m_header->stringsLength) {
+                qWarning("CatalogFile::validate, corrupted record %u", i);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// The search names of older files stay unused in the string table
+void CatalogFile::convertRecords() {
+    const CatalogFileRecordV2* records
+        = reinterpret_cast<const CatalogFileRecordV2*>(m_data + m_header->recordsOffset);
+    m_convertedRecords.resize(m_header->itemCount);
+    for (int i = 0; i < m_convertedRecords.size(); ++i) {
+        CatalogFileRecord& rec = m_convertedRecords[i];
+        rec.fullPath = records[i].fullPath;
+        rec.shortName = records[i].shortName;
+        rec.iconPath = records[i].iconPath;
+        rec.usage = records[i].usage;
+        rec.pluginId = records[i].pluginId;
+    }
+    m_records = m_convertedRecords.constData();
+}
+
+CatalogFileWriter::CatalogFileWriter()
+    : m_journalFingerprint(0) {
+
+}
+
+void CatalogFileWriter::reserve(int count) {
+    m_records.reserve(count);
+}
+
+void CatalogFileWriter::setJournalFingerprint(quint32 fingerprint) {
+    m_journalFingerprint = fingerprint;
+}
+
+void CatalogFileWriter::addItem(const CatItem& item) {
+    CatalogFileRecord rec;
+    rec.fullPath = appendString(m_strings, item.fullPath);
+    rec.shortName = appendString(m_strings, item.shortName);
+    rec.iconPath = appendString(m_strings, item.iconPath);
+    rec.usage = item.usage;
+    rec.pluginId = item.pluginId;
+    m_records.push_back(rec);
+}
+
+bool CatalogFileWriter::write(QIODevice* device) const {
+    CatalogFileHeader header;
+    header.magic = CatalogFile::MAGIC;
+    header.version = CatalogFile::VERSION;
+    header.itemCount = m_records.size();
+    header.recordSize = sizeof(CatalogFileRecord);
+    header.recordsOffset = sizeof(CatalogFileHeader);
+    header.stringsOffset = header.recordsOffset + m_records.size() * sizeof(CatalogFileRecord);
+    header.stringsLength = m_strings.size();
+    header.searchNamesLength = 0;
+    header.journalFingerprint = m_journalFingerprint;
+
+    qint64 recordsSize = m_records.size() * sizeof(CatalogFileRecord);
+    qint64 stringsSize = m_strings.size() * sizeof(ushort);
+
+    // The string table directly follows the records
+    quint32 checksum = updateCrc32(0, m_records.constData(), recordsSize);
+    header.checksum = updateCrc32(checksum, m_strings.constData(), stringsSize);
+
+    return device->write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header)
+        && device->write(reinterpret_cast<const char*>(m_records.constData()), recordsSize) == recordsSize
+        && device->write(reinterpret_cast<const char*>(m_strings.constData()), stringsSize) == stringsSize;
+}
+
+CatalogFileString CatalogFileWriter::appendString(QVector<ushort>& table, const QString& str) {
+    CatalogFileString result;
+    result.offset = table.size();
+    result.length = str.size();
+    table.resize(table.size() + str.size());
+    memcpy(table.data() + result.offset, str.utf16(), str.size() * sizeof(ushort));
+    return result;
+}
+
+}
@@ -0,0 +1,131 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QFile>
+#include <QVector>
+#include "CatalogItem.h"
+
+namespace launchy {
+
+/*
+  Binary catalog file layout, all values are stored in native byte order
+
+  CatalogFileHeader
+  CatalogFileRecord[itemCount]
+  string table, UTF-16 code units
+
+  Strings are referenced by offset and length in UTF-16 code units from the
+  start of the string table, they are not null terminated.
+
+  Since version 2 the header ends with a CRC-32 of the records and the
+  string table and the fingerprint of the rotated usage journal included
+  in the usage counts, version 1 headers stop before them.
+
+  Since version 3 the search names are not stored, they are derived from
+  the short name when the catalog is loaded. Records of older versions
+  are converted when the file is opened.
+*/
+
+struct CatalogFileString {
+    quint32 offset;
+    quint32 length;
+};
+
+struct CatalogFileRecord {
+    CatalogFileString fullPath;
+    CatalogFileString shortName;
+    CatalogFileString iconPath;
+    qint32 usage;
+    quint32 pluginId;
+};
+
+struct CatalogFileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 itemCount;
+    quint32 recordSize;
+    quint32 recordsOffset;
+    quint32 stringsOffset;
+    // Length of the whole string table, and before version 3 of the search names at its start
+    quint32 stringsLength;
+    quint32 searchNamesLength;
+    // Version 2 and later
+    quint32 checksum;
+    // See UsageJournal::fingerprint, 0 when no journal was rotated
+    quint32 journalFingerprint;
+};
+
+// CatalogFile maps a binary catalog file into memory,
+// records and strings are read in place without parsing the whole file
+class CatalogFile {
+public:
+    CatalogFile();
+    ~CatalogFile();
+
+    // Map and validate filename, return false if it is not a binary catalog
+    bool open(const QString& filename);
+    void close();
+
+    int count() const;
+    const CatalogFileRecord& record(int index) const;
+    const ushort* strings() const;
+    QString string(const CatalogFileString& str) const;
+    CatItem item(int index) const;
+    quint32 journalFingerprint() const;
+
+    static const quint32 MAGIC;
+    static const quint32 VERSION;
+
+private:
+    bool validate(qint64 fileSize) const;
+    void convertRecords();
+
+private:
+    QFile m_file;
+    const uchar* m_data;
+    const CatalogFileHeader* m_header;
+    const CatalogFileRecord* m_records;
+    const ushort* m_strings;
+    // Records of older versions converted to the current layout
+    QVector<CatalogFileRecord> m_convertedRecords;
+
+    Q_DISABLE_COPY(CatalogFile)
+};
+
+// CatalogFileWriter collects items and writes them as a binary catalog file
+class CatalogFileWriter {
+public:
+    CatalogFileWriter();
+
+    void reserve(int count);
+    void setJournalFingerprint(quint32 fingerprint);
+    void addItem(const CatItem& item);
+    bool write(QIODevice* device) const;
+
+private:
+    CatalogFileString appendString(QVector<ushort>& table, const QString& str);
+
+private:
+    QVector<CatalogFileRecord> m_records;
+    QVector<ushort> m_strings;
+    quint32 m_journalFingerprint;
+};
+
+}
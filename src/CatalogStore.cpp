@@ -0,0 +1,710 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "CatalogStore.h"
+#include "CatalogFile.h"
+#include "FrecencyStore.h"
+#include "SearchName.h"
+#include "SubsequenceMatch.h"
+
+namespace launchy {
+
+template <typename T>
+static void compact(QVector<T>& values, const QVector<bool>& removed) {
+    int count = 0;
+    for (int i = 0; i < values.size(); ++i) {
+        if (!removed.at(i)) {
+            if (count != i) {
+                values[count] = std::move(values[i]);
+            }
+            ++count;
+        }
+    }
+    values.resize(count);
+}
+
+template <typename T>
+static void permute(QVector<T>& values, const QVector<int>& order) {
+    QVector<T> permuted;
+    permuted.reserve(order.size());
+    foreach(int i, order) {
+        permuted.push_back(std::move(values[i]));
+    }
+    values.swap(permuted);
+}
+
+template <typename Char>
+static int indexOfText(const Char* data, int size, const QString& text) {
+    const ushort* match = text.utf16();
+    int matchLength = text.size();
+    for (int i = 0; i + matchLength <= size; ++i) {
+        int j = 0;
+        while (j < matchLength && data[i + j] == match[j]) {
+            ++j;
+        }
+        if (j == matchLength) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+SearchNameRef::SearchNameRef()
+    : m_data(nullptr),
+      m_size(0),
+      m_latin1(false) {
+
+}
+
+SearchNameRef::SearchNameRef(const QString* str)
+    : m_data(str->constData()),
+      m_size(str->size()),
+      m_latin1(false) {
+
+}
+
+SearchNameRef::SearchNameRef(const QChar* data, int size)
+    : m_data(data),
+      m_size(size),
+      m_latin1(false) {
+
+}
+
+SearchNameRef::SearchNameRef(const char* data, int size)
+    : m_data(data),
+      m_size(size),
+      m_latin1(true) {
+
+}
+
+int SearchNameRef::size() const {
+    return m_size;
+}
+
+bool SearchNameRef::isLatin1() const {
+    return m_latin1;
+}
+
+ushort SearchNameRef::at(int index) const {
+    if (m_latin1) {
+        return static_cast<const uchar*>(m_data)[index];
+    }
+    return static_cast<const ushort*>(m_data)[index];
+}
+
+int SearchNameRef::indexOf(const QString& text) const {
+    if (m_latin1) {
+        return indexOfText(static_cast<const uchar*>(m_data), m_size, text);
+    }
+    return indexOfText(static_cast<const ushort*>(m_data), m_size, text);
+}
+
+bool SearchNameRef::operator==(const QString& text) const {
+    return m_size == text.size() && indexOf(text) == 0;
+}
+
+QString SearchNameRef::toString() const {
+    if (m_latin1) {
+        return QString::fromLatin1(static_cast<const char*>(m_data), m_size);
+    }
+    return QString(static_cast<const QChar*>(m_data), m_size);
+}
+
+CatItemRef::CatItemRef()
+    : key(0),
+      usage(0),
+      frecency(FrecencyStore::NONE) {
+
+}
+
+CatItemRef::CatItemRef(const CatItem& item)
+    : key(CatalogStore::makeKey(QStringRef(&item.fullPath), QStringRef(&item.shortName))),
+      shortName(&item.shortName),
+      usage(item.usage),
+      frecency(FrecencyStore::NONE) {
+    searchName[CatItem::LOWER] = SearchNameRef(&item.searchName[CatItem::LOWER]);
+    searchName[CatItem::TRANS] = SearchNameRef(&item.searchName[CatItem::TRANS]);
+}
+
+CatalogStore::CatalogStore()
+    : m_searchGarbage(0),
+      m_latinGarbage(0),
+      m_coldGarbage(0) {
+
+}
+
+int CatalogStore::count() const {
+    return m_searchSpans.size();
+}
+
+void CatalogStore::clear() {
+    m_searchNames.clear();
+    m_latinNames.clear();
+    m_searchSpans.clear();
+    m_usage.clear();
+    m_frecency.clear();
+    m_pluginIds.clear();
+    m_keys.clear();
+    m_timestamps.clear();
+    m_coldStrings.clear();
+    m_coldSpans.clear();
+    m_directories.clear();
+    m_iconPaths.clear();
+    m_iconIndex.clear();
+    m_searchGarbage = 0;
+    m_latinGarbage = 0;
+    m_coldGarbage = 0;
+}
+
+void CatalogStore::reserve(int count) {
+    m_searchSpans.reserve(count);
+    m_usage.reserve(count);
+    m_frecency.reserve(count);
+    m_pluginIds.reserve(count);
+    m_keys.reserve(count);
+    m_timestamps.reserve(count);
+    m_coldSpans.reserve(count);
+}
+
+qint64 CatalogStore::memoryUsage() const {
+    qint64 size = (qint64)m_searchNames.capacity() * sizeof(QChar)
+        + m_latinNames.capacity()
+        + (qint64)m_searchSpans.capacity() * sizeof(SearchSpan)
+        + (qint64)m_usage.capacity() * sizeof(int)
+        + (qint64)m_frecency.capacity() * sizeof(float)
+        + (qint64)m_pluginIds.capacity() * sizeof(uint)
+        + (qint64)m_keys.capacity() * sizeof(quint64)
+        + (qint64)m_timestamps.capacity() * sizeof(int)
+        + (qint64)m_coldStrings.capacity() * sizeof(QChar)
+        + (qint64)m_coldSpans.capacity() * sizeof(ColdSpan)
+        + m_directories.memoryUsage();
+    foreach(const QString& icon, m_iconPaths) {
+        size += (qint64)icon.capacity() * sizeof(QChar);
+    }
+    return size;
+}
+
+int CatalogStore::append(const CatItem& item, int timestamp) {
+    const QString& lower = item.searchName[CatItem::LOWER];
+    const QString& trans = item.searchName[CatItem::TRANS];
+    SearchSpan span = storeSearchNames(lower.constData(), lower.size(),
+                                       trans.constData(), trans.size(), nullptr);
+
+    ColdSpan cold = storeCold(item.fullPath.constData(), item.fullPath.size(),
+                              item.shortName.constData(), item.shortName.size(),
+                              item.iconPath.constData(), item.iconPath.size(), nullptr);
+
+    m_searchSpans.push_back(span);
+    m_usage.push_back(item.usage);
+    m_frecency.push_back(FrecencyStore::NONE);
+    m_pluginIds.push_back(item.pluginId);
+    m_keys.push_back(makeKey(QStringRef(&item.fullPath), QStringRef(&item.shortName)));
+    m_timestamps.push_back(timestamp);
+    m_coldSpans.push_back(cold);
+    return m_searchSpans.size() - 1;
+}
+
+void CatalogStore::append(const CatalogFile& file, int begin, int end, int timestamp) {
+    // Reserve for the whole file up front when it is appended in parts
+    if (begin == 0) {
+        reserve(count() + file.count());
+    }
+
+    // Copy the strings straight from the mapped string table into the arenas
+    const QChar* strings = reinterpret_cast<const QChar*>(file.strings());
+    for (int i = begin; i < end; ++i) {
+        const CatalogFileRecord& rec = file.record(i);
+
+        const QChar* fullPath = strings + rec.fullPath.offset;
+        const QChar* shortName = strings + rec.shortName.offset;
+        SearchSpan span = deriveSearchNames(shortName, rec.shortName.length);
+        ColdSpan cold = storeCold(fullPath, rec.fullPath.length,
+                                  shortName, rec.shortName.length,
+                                  strings + rec.iconPath.offset, rec.iconPath.length, nullptr);
+
+        m_searchSpans.push_back(span);
+        m_usage.push_back(rec.usage);
+        m_frecency.push_back(FrecencyStore::NONE);
+        m_pluginIds.push_back(rec.pluginId);
+        m_timestamps.push_back(timestamp);
+        m_coldSpans.push_back(cold);
+        // The key is hashed straight from the mapped strings
+        QString fullPathData = QString::fromRawData(fullPath, rec.fullPath.length);
+        QString shortNameData = QString::fromRawData(shortName, rec.shortName.length);
+        m_keys.push_back(makeKey(QStringRef(&fullPathData), QStringRef(&shortNameData)));
+    }
+}
+
+void CatalogStore::replace(int slot, const CatItem& item, int timestamp) {
+    const QString& lower = item.searchName[CatItem::LOWER];
+    const QString& trans = item.searchName[CatItem::TRANS];
+    SearchSpan oldSpan = m_searchSpans.at(slot);
+    m_searchSpans[slot] = storeSearchNames(lower.constData(), lower.size(),
+                                           trans.constData(), trans.size(), &oldSpan);
+
+    ColdSpan old = m_coldSpans.at(slot);
+    m_coldSpans[slot] = storeCold(item.fullPath.constData(), item.fullPath.size(),
+                                  item.shortName.constData(), item.shortName.size(),
+                                  item.iconPath.constData(), item.iconPath.size(), &old);
+
+    m_pluginIds[slot] = item.pluginId;
+    m_keys[slot] = makeKey(QStringRef(&item.fullPath), QStringRef(&item.shortName));
+    m_timestamps[slot] = timestamp;
+
+    if (m_searchGarbage > m_searchNames.size() / 2
+        || m_latinGarbage > m_latinNames.size() / 2
+        || m_coldGarbage > m_coldStrings.size() / 2) {
+        squeeze();
+    }
+}
+
+void CatalogStore::remove(int slot) {
+    const SearchSpan& span = m_searchSpans.at(slot);
+    if (span.flags & LATIN1) {
+        m_latinGarbage += searchLength(span);
+    }
+    else {
+        m_searchGarbage += searchLength(span);
+    }
+    m_coldGarbage += coldLength(m_coldSpans.at(slot));
+
+    m_searchSpans.remove(slot);
+    m_usage.remove(slot);
+    m_frecency.remove(slot);
+    m_pluginIds.remove(slot);
+    m_keys.remove(slot);
+    m_timestamps.remove(slot);
+    m_coldSpans.remove(slot);
+}
+
+int CatalogStore::remove(const QVector<bool>& removed) {
+    int count = 0;
+    for (int slot = 0; slot < m_searchSpans.size(); ++slot) {
+        if (!removed.at(slot)) {
+            continue;
+        }
+        const SearchSpan& span = m_searchSpans.at(slot);
+        if (span.flags & LATIN1) {
+            m_latinGarbage += searchLength(span);
+        }
+        else {
+            m_searchGarbage += searchLength(span);
+        }
+        m_coldGarbage += coldLength(m_coldSpans.at(slot));
+        ++count;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    compact(m_searchSpans, removed);
+    compact(m_usage, removed);
+    compact(m_frecency, removed);
+    compact(m_pluginIds, removed);
+    compact(m_keys, removed);
+    compact(m_timestamps, removed);
+    compact(m_coldSpans, removed);
+    return count;
+}
+
+void CatalogStore::squeeze() {
+    // Removed slots leave capacity behind in the parallel arrays
+    if (m_searchSpans.capacity() > m_searchSpans.size()) {
+        m_searchSpans.squeeze();
+        m_usage.squeeze();
+        m_frecency.squeeze();
+        m_pluginIds.squeeze();
+        m_keys.squeeze();
+        m_timestamps.squeeze();
+        m_coldSpans.squeeze();
+    }
+
+    if (m_searchGarbage > 0 || m_latinGarbage > 0) {
+        packSearchNames();
+    }
+
+    if (m_coldGarbage > 0) {
+        QString strs;
+        strs.reserve(m_coldStrings.size() - m_coldGarbage);
+        for (int i = 0; i < m_coldSpans.size(); ++i) {
+            ColdSpan& cold = m_coldSpans[i];
+            int offset = strs.size();
+            strs.append(m_coldStrings.constData() + cold.offset, coldLength(cold));
+            cold.offset = offset;
+        }
+        m_coldStrings = strs;
+        m_coldGarbage = 0;
+    }
+}
+
+void CatalogStore::reorder(const QVector<int>& order) {
+    permute(m_searchSpans, order);
+    permute(m_usage, order);
+    permute(m_frecency, order);
+    permute(m_pluginIds, order);
+    permute(m_keys, order);
+    permute(m_timestamps, order);
+    permute(m_coldSpans, order);
+
+    // The cold strings are only read for displayed items and keep their order
+    packSearchNames();
+}
+
+void CatalogStore::packSearchNames() {
+    QString names;
+    QByteArray latinNames;
+    names.reserve(m_searchNames.size() - m_searchGarbage);
+    latinNames.reserve(m_latinNames.size() - m_latinGarbage);
+    for (int i = 0; i < m_searchSpans.size(); ++i) {
+        SearchSpan& span = m_searchSpans[i];
+        if (span.flags & LATIN1) {
+            int offset = latinNames.size();
+            latinNames.append(m_latinNames.constData() + span.offset, searchLength(span));
+            span.offset = offset;
+        }
+        else {
+            int offset = names.size();
+            names.append(m_searchNames.constData() + span.offset, searchLength(span));
+            span.offset = offset;
+        }
+    }
+    m_searchNames = names;
+    m_latinNames = latinNames;
+    m_searchGarbage = 0;
+    m_latinGarbage = 0;
+}
+
+CatItem CatalogStore::item(int slot) const {
+    CatItem item;
+    item.fullPath = fullPath(slot);
+    item.shortName = shortName(slot).toString();
+    item.searchName[CatItem::LOWER] = searchName(slot, CatItem::LOWER).toString();
+    if (m_searchSpans.at(slot).flags & SAME_TRANS) {
+        item.searchName[CatItem::TRANS] = item.searchName[CatItem::LOWER];
+    }
+    else {
+        item.searchName[CatItem::TRANS] = searchName(slot, CatItem::TRANS).toString();
+    }
+    item.iconPath = iconPath(slot).toString();
+    item.usage = m_usage.at(slot);
+    item.pluginId = m_pluginIds.at(slot);
+    return item;
+}
+
+CatItemRef CatalogStore::itemRef(int slot) const {
+    CatItemRef ref;
+    ref.key = m_keys.at(slot);
+    ref.shortName = shortName(slot);
+    ref.searchName[CatItem::LOWER] = searchName(slot, CatItem::LOWER);
+    ref.searchName[CatItem::TRANS] = searchName(slot, CatItem::TRANS);
+    ref.usage = m_usage.at(slot);
+    ref.frecency = m_frecency.at(slot);
+    return ref;
+}
+
+bool CatalogStore::equals(int slot, const CatItem& item) const {
+    return shortName(slot) == item.shortName && hasFullPath(slot, item.fullPath);
+}
+
+bool CatalogStore::hasFullPath(int slot, const QString& fullPath) const {
+    const ColdSpan& cold = m_coldSpans.at(slot);
+    const QChar* fileName = m_coldStrings.constData() + cold.offset;
+    int length = fullPath.size();
+    if (cold.directory < 0) {
+        return length == cold.fileNameLength
+            && memcmp(fullPath.constData(), fileName, length * sizeof(QChar)) == 0;
+    }
+
+    // The directory is followed by '/' and the file name
+    int directoryLength = length - cold.fileNameLength - 1;
+    return directoryLength >= 0
+        && fullPath.at(directoryLength) == QLatin1Char('/')
+        && memcmp(fullPath.constData() + directoryLength + 1, fileName,
+                  cold.fileNameLength * sizeof(QChar)) == 0
+        && m_directories.equals(cold.directory, fullPath.constData(), directoryLength);
+}
+
+// Return true if the search names of slot contain text as a subsequence,
+// the trans name follows the lower name so both are walked in one pass
+bool CatalogStore::matches(int slot, const QString& text) const {
+    const SearchSpan& span = m_searchSpans.at(slot);
+    int textLength = text.size();
+    if (!(span.flags & SAME_TRANS)) {
+        return subsequenceMatch(m_searchNames.constData() + span.offset,
+                                span.lowerLength + span.transLength,
+                                text.constData(), textLength) == textLength;
+    }
+
+    // Only the lower name is stored, the match continues into it a second
+    // time in place of the trans name
+    auto matchLower = [&](int from) {
+        if (span.flags & LATIN1) {
+            return subsequenceMatch(m_latinNames.constData() + span.offset, span.lowerLength,
+                                    text.constData() + from, textLength - from);
+        }
+        return subsequenceMatch(m_searchNames.constData() + span.offset, span.lowerLength,
+                                text.constData() + from, textLength - from);
+    };
+    int curChar = matchLower(0);
+    if (curChar < textLength) {
+        curChar += matchLower(curChar);
+    }
+    return curChar >= textLength;
+}
+
+quint64 CatalogStore::makeKey(const QStringRef& fullPath, const QStringRef& shortName) {
+    // 64-bit FNV-1a over the UTF-16 code units of fullPath and shortName,
+    // separated by a null unit so that ("ab", "c") and ("a", "bc") differ
+    const quint64 prime = Q_UINT64_C(1099511628211);
+    quint64 hash = Q_UINT64_C(14695981039346656037);
+
+    for (int i = 0; i < fullPath.size(); ++i) {
+        hash = (hash ^ fullPath.at(i).unicode()) * prime;
+    }
+    hash *= prime;
+    for (int i = 0; i < shortName.size(); ++i) {
+        hash = (hash ^ shortName.at(i).unicode()) * prime;
+    }
+    return hash;
+}
+
+quint64 CatalogStore::key(int slot) const {
+    return m_keys.at(slot);
+}
+
+int CatalogStore::usage(int slot) const {
+    return m_usage.at(slot);
+}
+
+void CatalogStore::setUsage(int slot, int usage) {
+    m_usage[slot] = usage;
+}
+
+float CatalogStore::frecency(int slot) const {
+    return m_frecency.at(slot);
+}
+
+void CatalogStore::setFrecency(int slot, float frecency) {
+    m_frecency[slot] = frecency;
+}
+
+uint CatalogStore::pluginId(int slot) const {
+    return m_pluginIds.at(slot);
+}
+
+int CatalogStore::timestamp(int slot) const {
+    return m_timestamps.at(slot);
+}
+
+void CatalogStore::setTimestamp(int slot, int timestamp) {
+    m_timestamps[slot] = timestamp;
+}
+
+SearchNameRef CatalogStore::searchName(int slot, CatItem::SearchNameType type) const {
+    const SearchSpan& span = m_searchSpans.at(slot);
+    if (type == CatItem::TRANS && !(span.flags & SAME_TRANS)) {
+        return SearchNameRef(m_searchNames.constData() + span.offset + span.lowerLength,
+                             span.transLength);
+    }
+    if (span.flags & LATIN1) {
+        return SearchNameRef(m_latinNames.constData() + span.offset, span.lowerLength);
+    }
+    return SearchNameRef(m_searchNames.constData() + span.offset, span.lowerLength);
+}
+
+QString CatalogStore::fullPath(int slot) const {
+    const ColdSpan& cold = m_coldSpans.at(slot);
+    const QChar* fileName = m_coldStrings.constData() + cold.offset;
+    if (cold.directory < 0) {
+        return QString(fileName, cold.fileNameLength);
+    }
+
+    int directoryLength = m_directories.length(cold.directory);
+    QString result(directoryLength + 1 + cold.fileNameLength, Qt::Uninitialized);
+    QChar* dst = result.data();
+    m_directories.copyPath(cold.directory, dst);
+    dst[directoryLength] = QLatin1Char('/');
+    memcpy(dst + directoryLength + 1, fileName, cold.fileNameLength * sizeof(QChar));
+    return result;
+}
+
+QStringRef CatalogStore::shortName(int slot) const {
+    const ColdSpan& cold = m_coldSpans.at(slot);
+    return QStringRef(&m_coldStrings, cold.offset + cold.shortNameOffset, cold.shortNameLength);
+}
+
+QStringRef CatalogStore::iconPath(int slot) const {
+    return QStringRef(&m_iconPaths.at(m_coldSpans.at(slot).icon));
+}
+
+CatalogStore::SearchSpan CatalogStore::storeSearchNames(const QChar* lower, int lowerLength,
+                                                       const QChar* trans, int transLength,
+                                                       const SearchSpan* old) {
+    bool same = transLength == lowerLength
+        && memcmp(lower, trans, lowerLength * sizeof(QChar)) == 0;
+    bool latin1 = same;
+    for (int i = 0; i < lowerLength && latin1; ++i) {
+        latin1 = lower[i].unicode() <= 0xff;
+    }
+
+    SearchSpan span;
+    span.lowerLength = lowerLength;
+    span.transLength = transLength;
+    span.flags = (latin1 ? LATIN1 : 0) | (same ? SAME_TRANS : 0);
+
+    // Space can only be reused within the same arena
+    int oldLength = old ? searchLength(*old) : 0;
+    bool reuse = old && (old->flags & LATIN1) == (span.flags & LATIN1);
+    if (old && !reuse) {
+        if (old->flags & LATIN1) {
+            m_latinGarbage += oldLength;
+        }
+        else {
+            m_searchGarbage += oldLength;
+        }
+    }
+
+    if (!latin1) {
+        const QChar* strs[] = { lower, trans };
+        int lengths[] = { lowerLength, transLength };
+        span.offset = appendSpan(m_searchNames, m_searchGarbage,
+                                 reuse ? old->offset : -1, reuse ? oldLength : 0,
+                                 strs, lengths, same ? 1 : 2);
+        return span;
+    }
+
+    if (reuse && lowerLength <= oldLength) {
+        span.offset = old->offset;
+        m_latinGarbage += oldLength - lowerLength;
+    }
+    else {
+        if (reuse) {
+            m_latinGarbage += oldLength;
+        }
+        span.offset = m_latinNames.size();
+        m_latinNames.resize(span.offset + lowerLength);
+    }
+    char* dst = m_latinNames.data() + span.offset;
+    for (int i = 0; i < lowerLength; ++i) {
+        dst[i] = (char)lower[i].unicode();
+    }
+    return span;
+}
+
+CatalogStore::SearchSpan CatalogStore::deriveSearchNames(const QChar* shortName, int length) {
+    if (!isAscii(shortName, length)) {
+        QString lower;
+        QString trans;
+        makeSearchNames(QString::fromRawData(shortName, length), lower, trans);
+        return storeSearchNames(lower.constData(), lower.size(),
+                                trans.constData(), trans.size(), nullptr);
+    }
+
+    // Lower case ASCII names are their own trans names
+    SearchSpan span;
+    span.offset = m_latinNames.size();
+    span.lowerLength = length;
+    span.transLength = length;
+    span.flags = LATIN1 | SAME_TRANS;
+    m_latinNames.resize(span.offset + length);
+    asciiToLower(shortName, length, m_latinNames.data() + span.offset);
+    return span;
+}
+
+int CatalogStore::searchLength(const SearchSpan& span) {
+    return span.lowerLength + (span.flags & SAME_TRANS ? 0 : span.transLength);
+}
+
+CatalogStore::ColdSpan CatalogStore::storeCold(const QChar* fullPath, int fullPathLength,
+                                               const QChar* shortName, int shortNameLength,
+                                               const QChar* iconPath, int iconPathLength,
+                                               const ColdSpan* old) {
+    int separator = fullPathLength - 1;
+    while (separator >= 0 && fullPath[separator] != QLatin1Char('/')) {
+        --separator;
+    }
+
+    ColdSpan cold;
+    cold.directory = separator >= 0 ? m_directories.insert(fullPath, separator) : -1;
+    cold.fileNameLength = fullPathLength - separator - 1;
+    const QChar* fileName = fullPath + separator + 1;
+
+    // Short names are mostly the file name without its extension
+    bool shared = shortNameLength <= cold.fileNameLength
+        && memcmp(fileName, shortName, shortNameLength * sizeof(QChar)) == 0;
+    cold.shortNameOffset = shared ? 0 : cold.fileNameLength;
+    cold.shortNameLength = shortNameLength;
+
+    const QChar* strs[] = { fileName, shortName };
+    int lengths[] = { cold.fileNameLength, shortNameLength };
+    cold.offset = appendSpan(m_coldStrings, m_coldGarbage,
+                             old ? old->offset : -1, old ? coldLength(*old) : 0,
+                             strs, lengths, shared ? 1 : 2);
+    cold.icon = internIcon(iconPath, iconPathLength);
+    return cold;
+}
+
+int CatalogStore::internIcon(const QChar* iconPath, int length) {
+    // Most items share the icon of their plugin or file type
+    QString icon = QString::fromRawData(iconPath, length);
+    QHash<QString, int>::const_iterator it = m_iconIndex.constFind(icon);
+    if (it != m_iconIndex.constEnd()) {
+        return it.value();
+    }
+
+    icon = QString(iconPath, length);
+    m_iconPaths.push_back(icon);
+    m_iconIndex.insert(icon, m_iconPaths.size() - 1);
+    return m_iconPaths.size() - 1;
+}
+
+int CatalogStore::coldLength(const ColdSpan& cold) {
+    return qMax(cold.fileNameLength, cold.shortNameOffset + cold.shortNameLength);
+}
+
+// Write strs one after another into arena, reusing the span at oldOffset
+// when they fit into it, and return the offset they were written at
+int CatalogStore::appendSpan(QString& arena, int& garbage, int oldOffset, int oldLength,
+                             const QChar* const* strs, const int* lengths, int count) {
+    int total = 0;
+    for (int i = 0; i < count; ++i) {
+        total += lengths[i];
+    }
+
+    if (oldOffset >= 0 && total <= oldLength) {
+        QChar* dst = arena.data() + oldOffset;
+        for (int i = 0; i < count; ++i) {
+            memcpy(dst, strs[i], lengths[i] * sizeof(QChar));
+            dst += lengths[i];
+        }
+        garbage += oldLength - total;
+        return oldOffset;
+    }
+
+    if (oldOffset >= 0) {
+        garbage += oldLength;
+    }
+    int offset = arena.size();
+    for (int i = 0; i < count; ++i) {
+        arena.append(strs[i], lengths[i]);
+    }
+    return offset;
+}
+
+}
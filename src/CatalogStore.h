@@ -0,0 +1,197 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringRef>
+#include <QVector>
+#include "CatalogItem.h"
+#include "PathTree.h"
+
+namespace launchy {
+class CatalogFile;
+
+// SearchNameRef refers to a search name that is stored either as UTF-16
+// or as Latin-1, it is only valid as long as the storage is not modified
+class SearchNameRef {
+public:
+    SearchNameRef();
+    explicit SearchNameRef(const QString* str);
+    SearchNameRef(const QChar* data, int size);
+    SearchNameRef(const char* data, int size);
+
+    int size() const;
+    bool isLatin1() const;
+    ushort at(int index) const;
+    // Position of the first occurrence of text, or -1
+    int indexOf(const QString& text) const;
+    bool operator==(const QString& text) const;
+    QString toString() const;
+
+private:
+    const void* m_data;
+    int m_size;
+    bool m_latin1;
+};
+
+// CatItemRef refers to the fields of an item that are used for ranking,
+// it is only valid as long as the item it was taken from is not modified
+struct CatItemRef {
+    CatItemRef();
+    explicit CatItemRef(const CatItem& item);
+
+    // Identity key, see CatalogStore::makeKey
+    quint64 key;
+    QStringRef shortName;
+    SearchNameRef searchName[CatItem::CAPACITY];
+    int usage;
+    // Decayed launch score, see FrecencyStore
+    float frecency;
+};
+
+// CatalogStore keeps the catalog items as parallel arrays indexed by slot.
+// The search names of all items are packed into one UTF-16 arena, the lower
+// name of an item is directly followed by its trans name, so matching an item
+// is a single pass over contiguous memory. The trans name is only stored when
+// it differs from the lower name, and names that fit in Latin-1 are kept in
+// an arena of one byte per character. Names live in a separate cold arena
+// which is only read for the results that are displayed. Directories are
+// interned in a PathTree and icon paths in a table, full paths are built
+// from the directory and the file name when they are needed.
+class CatalogStore {
+public:
+    CatalogStore();
+
+    int count() const;
+    void clear();
+    void reserve(int count);
+    // Approximate heap memory used by the store in bytes
+    qint64 memoryUsage() const;
+
+    int append(const CatItem& item, int timestamp);
+    // Append the items [begin, end) of a binary catalog file without creating CatItems
+    void append(const CatalogFile& file, int begin, int end, int timestamp);
+    // Replace the item at slot, the usage and frecency of the slot are kept
+    void replace(int slot, const CatItem& item, int timestamp);
+    void remove(int slot);
+    // Remove the slots marked in removed in one pass keeping the order of the
+    // others, return the number of removed slots
+    int remove(const QVector<bool>& removed);
+    // Move the item at slot order[i] to slot i, the search names are packed
+    // in the new order so a scan in slot order reads the arenas sequentially
+    void reorder(const QVector<int>& order);
+    // Release the memory of removed and replaced items
+    void squeeze();
+
+    CatItem item(int slot) const;
+    CatItemRef itemRef(int slot) const;
+    bool equals(int slot, const CatItem& item) const;
+    // Return true if fullPath is the full path of slot, without building it
+    bool hasFullPath(int slot, const QString& fullPath) const;
+    bool matches(int slot, const QString& text) const;
+
+    // 64-bit identity key hashed from the fullPath and shortName of an item
+    static quint64 makeKey(const QStringRef& fullPath, const QStringRef& shortName);
+
+    quint64 key(int slot) const;
+    int usage(int slot) const;
+    void setUsage(int slot, int usage);
+    float frecency(int slot) const;
+    void setFrecency(int slot, float frecency);
+    uint pluginId(int slot) const;
+    int timestamp(int slot) const;
+    void setTimestamp(int slot, int timestamp);
+
+    SearchNameRef searchName(int slot, CatItem::SearchNameType type) const;
+    QString fullPath(int slot) const;
+    QStringRef shortName(int slot) const;
+    QStringRef iconPath(int slot) const;
+
+private:
+    enum SearchSpanFlags {
+        // The names are in m_latinNames instead of m_searchNames
+        LATIN1 = 1,
+        // The trans name equals the lower name and is not stored
+        SAME_TRANS = 2
+    };
+
+    struct SearchSpan {
+        int offset;
+        int lowerLength;
+        int transLength;
+        int flags;
+    };
+
+    struct ColdSpan {
+        int offset;
+        // Node of the directory in m_directories, -1 if the full path has no '/'
+        int directory;
+        // Part of the full path after the last '/'
+        int fileNameLength;
+        // A short name the file name starts with is not stored again, its offset is 0
+        int shortNameOffset;
+        int shortNameLength;
+        // Index in m_iconPaths
+        int icon;
+    };
+
+    // Store the search names of an item, reusing the arena space of old if there is one
+    SearchSpan storeSearchNames(const QChar* lower, int lowerLength,
+                                const QChar* trans, int transLength, const SearchSpan* old);
+    // Derive and store the search names of shortName, as the CatItem constructors do
+    SearchSpan deriveSearchNames(const QChar* shortName, int length);
+    static int searchLength(const SearchSpan& span);
+    // Copy the search names of all slots to new arenas in slot order
+    void packSearchNames();
+    // Store the cold strings of an item, reusing the arena space of old if there is one
+    ColdSpan storeCold(const QChar* fullPath, int fullPathLength,
+                       const QChar* shortName, int shortNameLength,
+                       const QChar* iconPath, int iconPathLength, const ColdSpan* old);
+    int internIcon(const QChar* iconPath, int length);
+    static int coldLength(const ColdSpan& cold);
+    static int appendSpan(QString& arena, int& garbage, int oldOffset, int oldLength,
+                          const QChar* const* strs, const int* lengths, int count);
+
+private:
+    // hot data, read by every search
+    QString m_searchNames;
+    QByteArray m_latinNames;
+    QVector<SearchSpan> m_searchSpans;
+    QVector<int> m_usage;
+    QVector<float> m_frecency;
+    QVector<uint> m_pluginIds;
+
+    // cold data
+    QVector<quint64> m_keys;
+    QVector<int> m_timestamps;
+    QString m_coldStrings;
+    QVector<ColdSpan> m_coldSpans;
+    PathTree m_directories;
+    QVector<QString> m_iconPaths;
+    QHash<QString, int> m_iconIndex;
+
+    // Arena units no longer referenced by any slot
+    int m_searchGarbage;
+    int m_latinGarbage;
+    int m_coldGarbage;
+};
+
+}
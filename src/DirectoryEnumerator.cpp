@@ -0,0 +1,386 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "DirectoryEnumerator.h"
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace launchy {
+
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+static const bool IGNORE_CASE = true;
+#else
+static const bool IGNORE_CASE = false;
+#endif
+
+// Fold case only where the names are matched ignoring it
+static char foldCase(char c) {
+    return IGNORE_CASE && c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+// Same translation QRegExp::Wildcard does, for the patterns the glob can not match
+static QString wildcardToRegExp(const QString& pattern) {
+    QString result("^");
+    for (int i = 0; i < pattern.size(); ++i) {
+        QChar c = pattern.at(i);
+        if (c == '*') {
+            result += ".*";
+        }
+        else if (c == '?') {
+            result += '.';
+        }
+        else if (c == '[') {
+            int end = pattern.indexOf(']', i + 2);
+            if (end < 0) {
+                result += "\\[";
+                continue;
+            }
+            QString set = pattern.mid(i + 1, end - i - 1);
+            if (set.startsWith('!')) {
+                set[0] = '^';
+            }
+            result += '[' + set.replace("\\", "\\\\") + ']';
+            i = end;
+        }
+        else {
+            result += QRegularExpression::escape(QString(c));
+        }
+    }
+    return result + '$';
+}
+
+NameFilter::NameFilter() {
+
+}
+
+NameFilter::NameFilter(const QStringList& patterns) {
+    foreach(const QString& pattern, patterns) {
+        Pattern compiled;
+        bool ascii = true;
+        for (int i = 0; i < pattern.size(); ++i) {
+            ushort c = pattern.at(i).unicode();
+            if (c == 0 || c >= 0x80 || c == '[') {
+                ascii = false;
+                break;
+            }
+        }
+
+        if (ascii) {
+            compiled.glob = pattern.toLatin1();
+            for (int i = 0; i < compiled.glob.size(); ++i) {
+                compiled.glob[i] = foldCase(compiled.glob.at(i));
+            }
+        }
+        else {
+            compiled.regExp = QRegularExpression(wildcardToRegExp(pattern),
+                                                 IGNORE_CASE ? QRegularExpression::CaseInsensitiveOption
+                                                             : QRegularExpression::NoPatternOption);
+            compiled.regExp.optimize();
+        }
+        m_patterns.push_back(compiled);
+    }
+}
+
+bool NameFilter::isEmpty() const {
+    return m_patterns.isEmpty();
+}
+
+bool NameFilter::matches(const char* name, int length) const {
+    QString decoded;
+    for (int i = 0; i < m_patterns.size(); ++i) {
+        const Pattern& pattern = m_patterns.at(i);
+        if (!pattern.glob.isEmpty()) {
+            if (matchGlob(pattern.glob, name, length)) {
+                return true;
+            }
+            continue;
+        }
+
+        if (decoded.isNull()) {
+            decoded = QFile::decodeName(QByteArray::fromRawData(name, length));
+        }
+        if (pattern.regExp.match(decoded).hasMatch()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NameFilter::matchGlob(const QByteArray& glob, const char* name, int length) {
+    const char* p = glob.constData();
+    const char* pend = p + glob.size();
+    const char* s = name;
+    const char* send = name + length;
+    // Where to retry after the last star when the rest does not match
+    const char* starP = nullptr;
+    const char* starS = nullptr;
+
+    while (s < send) {
+        if (p < pend && *p == '*') {
+            starP = ++p;
+            starS = s;
+        }
+        else if (p < pend && *p == '?') {
+            // One character, which can be several bytes in UTF-8
+            ++p;
+            ++s;
+            while (s < send && ((uchar)*s & 0xc0) == 0x80) {
+                ++s;
+            }
+        }
+        else if (p < pend && *p == foldCase(*s)) {
+            ++p;
+            ++s;
+        }
+        else if (starP) {
+            p = starP;
+            s = ++starS;
+        }
+        else {
+            return false;
+        }
+    }
+
+    while (p < pend && *p == '*') {
+        ++p;
+    }
+    return p == pend;
+}
+
+#ifdef Q_OS_LINUX
+
+// Record returned by getdents64, glibc does not declare it under this name
+struct LinuxDirent64 {
+    quint64 d_ino;
+    qint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+DirectoryEnumerator::DirectoryEnumerator(const QString& path)
+    : m_fd(open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)),
+      m_size(0),
+      m_offset(0),
+      m_name(nullptr),
+      m_nameLength(0),
+      m_dirType(DT_UNKNOWN),
+      m_typeKnown(false),
+      m_type(OtherEntry) {
+
+}
+
+DirectoryEnumerator::~DirectoryEnumerator() {
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+bool DirectoryEnumerator::isOpen() const {
+    return m_fd >= 0;
+}
+
+bool DirectoryEnumerator::next() {
+    if (m_fd < 0) {
+        return false;
+    }
+
+    for (;;) {
+        if (m_offset >= m_size) {
+            long size = syscall(SYS_getdents64, m_fd, m_buffer, sizeof(m_buffer));
+            if (size <= 0) {
+                return false;
+            }
+            m_size = (int)size;
+            m_offset = 0;
+        }
+
+        const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(m_buffer + m_offset);
+        m_offset += entry->d_reclen;
+        const char* name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+
+        m_name = name;
+        m_nameLength = (int)strlen(name);
+        m_dirType = entry->d_type;
+        m_typeKnown = false;
+        return true;
+    }
+}
+
+const char* DirectoryEnumerator::name() const {
+    return m_name;
+}
+
+int DirectoryEnumerator::nameLength() const {
+    return m_nameLength;
+}
+
+QString DirectoryEnumerator::fileName() const {
+    return QFile::decodeName(QByteArray::fromRawData(m_name, m_nameLength));
+}
+
+bool DirectoryEnumerator::isHidden() const {
+    return m_name[0] == '.';
+}
+
+DirectoryEnumerator::EntryType DirectoryEnumerator::type() {
+    if (m_typeKnown) {
+        return m_type;
+    }
+
+    m_typeKnown = true;
+    switch (m_dirType) {
+    case DT_DIR:
+        m_type = DirEntry;
+        break;
+    case DT_REG:
+        m_type = FileEntry;
+        break;
+    case DT_LNK:
+    case DT_UNKNOWN: {
+        struct stat info;
+        if (fstatat(m_fd, m_name, &info, 0) != 0) {
+            m_type = OtherEntry;
+        }
+        else if (S_ISDIR(info.st_mode)) {
+            m_type = DirEntry;
+        }
+        else if (S_ISREG(info.st_mode)) {
+            m_type = FileEntry;
+        }
+        else {
+            m_type = OtherEntry;
+        }
+        break;
+    }
+    default:
+        m_type = OtherEntry;
+        break;
+    }
+    return m_type;
+}
+
+bool DirectoryEnumerator::isExecutable() {
+    return faccessat(m_fd, m_name, X_OK, 0) == 0;
+}
+
+static qint64 toNanoseconds(const struct timespec& time) {
+    return (qint64)time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+qint64 DirectoryEnumerator::modificationTime() {
+    struct stat info;
+    if (fstatat(m_fd, m_name, &info, 0) != 0) {
+        return -1;
+    }
+    return toNanoseconds(info.st_mtim);
+}
+
+bool DirectoryEnumerator::status(const QString& path, qint64& mtime, quint64& inode) {
+    struct stat info;
+    if (stat(QFile::encodeName(path).constData(), &info) != 0) {
+        return false;
+    }
+    mtime = toNanoseconds(info.st_mtim);
+    inode = info.st_ino;
+    return true;
+}
+
+#else
+
+DirectoryEnumerator::DirectoryEnumerator(const QString& path)
+    : m_iterator(path, QDir::AllEntries | QDir::System | QDir::Hidden | QDir::NoDotAndDotDot) {
+
+}
+
+DirectoryEnumerator::~DirectoryEnumerator() {
+
+}
+
+bool DirectoryEnumerator::isOpen() const {
+    return QFileInfo(m_iterator.path()).isDir();
+}
+
+bool DirectoryEnumerator::next() {
+    if (!m_iterator.hasNext()) {
+        return false;
+    }
+    m_iterator.next();
+    m_name = QFile::encodeName(m_iterator.fileName());
+    return true;
+}
+
+const char* DirectoryEnumerator::name() const {
+    return m_name.constData();
+}
+
+int DirectoryEnumerator::nameLength() const {
+    return m_name.size();
+}
+
+QString DirectoryEnumerator::fileName() const {
+    return m_iterator.fileName();
+}
+
+bool DirectoryEnumerator::isHidden() const {
+    return m_iterator.fileInfo().isHidden();
+}
+
+DirectoryEnumerator::EntryType DirectoryEnumerator::type() {
+    QFileInfo info = m_iterator.fileInfo();
+    if (info.isDir()) {
+        return DirEntry;
+    }
+    if (info.isFile()) {
+        return FileEntry;
+    }
+    return OtherEntry;
+}
+
+bool DirectoryEnumerator::isExecutable() {
+    return m_iterator.fileInfo().isExecutable();
+}
+
+qint64 DirectoryEnumerator::modificationTime() {
+    QDateTime time = m_iterator.fileInfo().lastModified();
+    return time.isValid() ? time.toMSecsSinceEpoch() * 1000000 : -1;
+}
+
+bool DirectoryEnumerator::status(const QString& path, qint64& mtime, quint64& inode) {
+    QFileInfo info(path);
+    if (!info.exists()) {
+        return false;
+    }
+    mtime = info.lastModified().toMSecsSinceEpoch() * 1000000;
+    inode = 0;
+    return true;
+}
+
+#endif
+
+}
@@ -0,0 +1,115 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QDirIterator>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace launchy {
+
+// NameFilter matches file names against wildcard patterns. Like the file
+// systems, matching ignores case on Windows and macOS only, so a filter
+// such as *.desktop does not pick up *.DESKTOP files on Linux. The patterns
+// are compiled once, plain ASCII patterns match the encoded names directly
+// so names that do not match are never decoded.
+class NameFilter {
+public:
+    NameFilter();
+    explicit NameFilter(const QStringList& patterns);
+
+    bool isEmpty() const;
+    // Match a name in the encoding of QFile::encodeName
+    bool matches(const char* name, int length) const;
+
+private:
+    struct Pattern {
+        // ASCII wildcard pattern, lower case where case is ignored, empty if regExp is used
+        QByteArray glob;
+        QRegularExpression regExp;
+    };
+
+    static bool matchGlob(const QByteArray& glob, const char* name, int length);
+
+private:
+    QVector<Pattern> m_patterns;
+};
+
+// DirectoryEnumerator reads a directory once and classifies each entry from
+// the type stored in the directory, the file itself is only looked at for
+// symbolic links, file systems without entry types and executable checks.
+// On Linux the entries are read with getdents64, elsewhere QDirIterator is used.
+class DirectoryEnumerator {
+public:
+    enum EntryType {
+        DirEntry,
+        FileEntry,
+        // Special files and broken links, QDir::System
+        OtherEntry
+    };
+
+    explicit DirectoryEnumerator(const QString& path);
+    ~DirectoryEnumerator();
+
+    bool isOpen() const;
+    // Move to the next entry other than . and .., false at the end
+    bool next();
+
+    // Name of the entry in the encoding of QFile::encodeName
+    const char* name() const;
+    int nameLength() const;
+    QString fileName() const;
+    bool isHidden() const;
+    // Type of the entry, symbolic links are followed
+    EntryType type();
+    // Whether the current user may execute the entry, like QFileInfo::isExecutable
+    bool isExecutable();
+    // Modification time of the entry in nanoseconds since the epoch, or -1
+    qint64 modificationTime();
+
+    // Read the modification time in nanoseconds since the epoch and the
+    // inode of a file, the inode is 0 where it is not available
+    static bool status(const QString& path, qint64& mtime, quint64& inode);
+
+private:
+    Q_DISABLE_COPY(DirectoryEnumerator)
+
+#ifdef Q_OS_LINUX
+    enum {
+        BUFFER_SIZE = 32 * 1024
+    };
+
+    int m_fd;
+    alignas(8) char m_buffer[BUFFER_SIZE];
+    int m_size;
+    int m_offset;
+    const char* m_name;
+    int m_nameLength;
+    unsigned char m_dirType;
+    bool m_typeKnown;
+    EntryType m_type;
+#else
+    QDirIterator m_iterator;
+    QByteArray m_name;
+#endif
+};
+
+}
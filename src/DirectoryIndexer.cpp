@@ -0,0 +1,363 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "DirectoryIndexer.h"
+#include <QtConcurrent>
+#include "Catalog.h"
+
+namespace launchy {
+
+// Files modified this many milliseconds before the walk started are checked
+// again by the next walk, a change in the same clock tick would go unnoticed
+static const qint64 RACY_INTERVAL = 2000;
+
+static void stage(DirectoryIndexer::Listing& listing, const QString& name, const CatItem& item,
+                  bool alter, qint64 mtime) {
+    DirectoryManifestItem record;
+    record.name = name;
+    record.mtime = mtime;
+    record.key = 0;
+    DirectoryIndexer::Item staged;
+    staged.item = item;
+    staged.alter = alter;
+    staged.record = listing.entry.items.size();
+    listing.entry.items.push_back(record);
+    listing.items.push_back(staged);
+}
+
+DirectoryIndexer::DirectoryIndexer(const QList<Directory>& roots, int threadCount,
+                                   const DirectoryManifest* manifest, const Catalog* catalog)
+    : m_roots(roots),
+      m_manifest(manifest),
+      m_catalog(catalog),
+      m_listRoots(false),
+      m_racyTime((QDateTime::currentMSecsSinceEpoch() - RACY_INTERVAL) * 1000000),
+      m_pending(0),
+      m_queued(0),
+      m_rootPending(new std::atomic<int>[roots.count()]),
+      m_directoryCount(0),
+      m_unchangedCount(0),
+      m_canceled(false),
+      m_idleWorkers(0),
+      m_done(roots.count(), false) {
+    if (threadCount <= 0) {
+        threadCount = QThread::idealThreadCount();
+    }
+    threadCount = qMax(1, threadCount);
+    m_pool.setMaxThreadCount(threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        m_workers.emplace_back(new Worker);
+        m_workers.back()->staged.resize(roots.count());
+    }
+    for (int i = 0; i < roots.count(); ++i) {
+        m_rootPending[i] = 0;
+        const Directory& root = roots.at(i);
+        m_filters.push_back(NameFilter(root.types));
+        // The lowest bit is set by the directories that walk their subdirectories
+        m_configs.push_back(qHash(root.types.join('\n')) << 3
+                            | (root.indexDirs ? 4 : 0) | (root.indexExe ? 2 : 0));
+    }
+}
+
+DirectoryIndexer::~DirectoryIndexer() {
+    // The workers drop the remaining tasks without listing them
+    m_canceled = true;
+    foreach(QFuture<void> future, m_futures) {
+        future.waitForFinished();
+    }
+}
+
+void DirectoryIndexer::setListRoots(bool listRoots) {
+    m_listRoots = listRoots;
+}
+
+void DirectoryIndexer::start() {
+    // Deal the roots out to the workers, idle workers steal from the others
+    for (int i = 0; i < m_roots.count(); ++i) {
+        Task task;
+        task.path = m_roots.at(i).name;
+        task.root = i;
+        task.depth = m_roots.at(i).depth;
+        push(*m_workers[i % m_workers.size()], task);
+    }
+    for (int i = 0; i < (int)m_workers.size(); ++i) {
+        m_futures.push_back(QtConcurrent::run(&m_pool, [this, i]() {
+            work(i);
+        }));
+    }
+}
+
+QVector<DirectoryIndexer::Listing> DirectoryIndexer::takeListings(int root) {
+    {
+        QMutexLocker locker(&m_doneMutex);
+        while (!m_done.at(root)) {
+            m_rootDone.wait(&m_doneMutex);
+        }
+    }
+
+    QVector<Listing> listings;
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        listings += m_workers[i]->staged[root];
+        m_workers[i]->staged[root].clear();
+    }
+    return listings;
+}
+
+int DirectoryIndexer::directoryCount() const {
+    return m_directoryCount;
+}
+
+int DirectoryIndexer::unchangedCount() const {
+    return m_unchangedCount;
+}
+
+void DirectoryIndexer::work(int index) {
+    // Like the builder thread, the walk only uses the time the rest of the system leaves
+    QThread::currentThread()->setPriority(QThread::IdlePriority);
+
+    Worker& worker = *m_workers[index];
+    // A running task adds its subdirectories before it finishes,
+    // so no task is pending only when every root is walked
+    while (m_pending > 0) {
+        Task task;
+        if (!takeTask(index, task)) {
+            waitForTask();
+            continue;
+        }
+
+        if (!m_canceled) {
+            walkDirectory(worker, task);
+        }
+        finishTask(task);
+    }
+}
+
+bool DirectoryIndexer::takeTask(int index, Task& task) {
+    // The newest task of its own is closest to the directories the worker just listed
+    {
+        Worker& own = *m_workers[index];
+        QMutexLocker locker(&own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --m_queued;
+            return true;
+        }
+    }
+
+    // The oldest task of another worker is the closest to a root, with the most work below it
+    for (size_t i = 1; i < m_workers.size(); ++i) {
+        Worker& victim = *m_workers[(index + i) % m_workers.size()];
+        QMutexLocker locker(&victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --m_queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirectoryIndexer::walkDirectory(Worker& worker, const Task& task) {
+    ++m_directoryCount;
+
+    Listing listing;
+    listing.path = QDir(QDir::toNativeSeparators(task.path)).absolutePath();
+    // App directories are only added while there are levels left to walk
+    listing.entry.config = m_configs.at(task.root) | (task.depth > 0 ? 1 : 0);
+    const DirectoryManifestEntry* previous = m_manifest->find(listing.path);
+    if (previous && previous->config != listing.entry.config) {
+        previous = nullptr;
+    }
+
+    qint64 mtime = -1;
+    quint64 inode = 0;
+    DirectoryEnumerator::status(listing.path, mtime, inode);
+    // Only the roots are walked with their full depth
+    bool listed = m_listRoots && task.depth == m_roots.at(task.root).depth;
+    if (!listed && previous && mtime >= 0 && previous->mtime == mtime && previous->inode == inode
+        && reuseEntry(*previous, listing)) {
+        ++m_unchangedCount;
+    }
+    else {
+        listing.entry.mtime = mtime < m_racyTime ? mtime : -1;
+        listing.entry.inode = inode;
+        listDirectory(task, previous, listing);
+    }
+
+    // Subdirectories may have changed even if their parent did not
+    if (task.depth > 0) {
+        foreach(const QString& name, listing.entry.subdirectories) {
+            Task child;
+            child.path = listing.path + "/" + name;
+            child.root = task.root;
+            child.depth = task.depth - 1;
+            push(worker, child);
+        }
+    }
+    worker.staged[task.root].push_back(listing);
+}
+
+bool DirectoryIndexer::reuseEntry(const DirectoryManifestEntry& previous, Listing& listing) const {
+    QVector<quint64> keys;
+    keys.reserve(previous.items.size());
+    foreach(const DirectoryManifestItem& item, previous.items) {
+        if (item.mtime < 0) {
+            return false;
+        }
+        if (item.key != 0) {
+            keys.push_back(item.key);
+        }
+    }
+    if (!m_catalog->containsItems(keys)) {
+        return false;
+    }
+
+    listing.entry = previous;
+    listing.reused = keys;
+    return true;
+}
+
+void DirectoryIndexer::listDirectory(const Task& task, const DirectoryManifestEntry* previous,
+                                     Listing& listing) {
+    const Directory& root = m_roots.at(task.root);
+    const NameFilter& filter = m_filters.at(task.root);
+    const QString& dir = listing.path;
+
+    // Altered files of the previous listing, their items are kept while the file is unchanged
+    QHash<QString, int> previousFiles;
+    if (previous) {
+        for (int i = 0; i < previous->items.size(); ++i) {
+            if (previous->items.at(i).mtime > 0) {
+                previousFiles.insert(previous->items.at(i).name, i);
+            }
+        }
+    }
+
+    DirectoryEnumerator entries(dir);
+    while (entries.next()) {
+        // Hidden entries are left out like QDir does by default
+        if (entries.isHidden()) {
+            continue;
+        }
+        ++listing.entry.childCount;
+
+        DirectoryEnumerator::EntryType type = entries.type();
+        if (type == DirectoryEnumerator::DirEntry) {
+            QString name = entries.fileName();
+            if (name.startsWith(".")) {
+                continue;
+            }
+            QString path = dir + "/" + name;
+            bool isShortcut = name.endsWith(".lnk", Qt::CaseInsensitive);
+            if (!name.contains(".lnk")) {
+#ifdef Q_OS_MAC
+                // Special handling of app directories
+                if (task.depth > 0 && name.endsWith(".app", Qt::CaseInsensitive)) {
+                    stage(listing, name, CatItem(path), true, 0);
+                }
+                else
+#endif
+                    listing.entry.subdirectories.push_back(name);
+            }
+
+            if (root.indexDirs) {
+                stage(listing, name, CatItem(path, !isShortcut), false, 0);
+            }
+            else if (isShortcut) {
+                // Grab any shortcut directories
+                // This is to work around a QT weirdness that treats shortcuts to directories as actual directories
+                stage(listing, name, CatItem(path, true), false, 0);
+            }
+            continue;
+        }
+
+        // Executables are added as they are even if they match the file types too
+        if (root.indexExe && type == DirectoryEnumerator::FileEntry && entries.isExecutable()) {
+            QString name = entries.fileName();
+            stage(listing, name, CatItem(dir + "/" + name), false, 0);
+            continue;
+        }
+
+        // An empty file filter matches nothing
+        if (filter.isEmpty() || !filter.matches(entries.name(), entries.nameLength())) {
+            continue;
+        }
+
+        QString name = entries.fileName();
+        qint64 mtime = entries.modificationTime();
+        if (mtime >= m_racyTime) {
+            mtime = -1;
+        }
+        QHash<QString, int>::const_iterator it = previousFiles.constFind(name);
+        if (mtime > 0 && it != previousFiles.constEnd()) {
+            const DirectoryManifestItem& old = previous->items.at(it.value());
+            if (old.mtime == mtime
+                && (old.key == 0 || m_catalog->containsItems(QVector<quint64>(1, old.key)))) {
+                listing.entry.items.push_back(old);
+                if (old.key != 0) {
+                    listing.reused.push_back(old.key);
+                }
+                continue;
+            }
+        }
+        stage(listing, name, CatItem(dir + "/" + name), true, mtime);
+    }
+}
+
+void DirectoryIndexer::waitForTask() {
+    QMutexLocker locker(&m_idleMutex);
+    // Counted before checking for tasks, so a push either sees this worker
+    // waiting or this worker sees the pushed task
+    ++m_idleWorkers;
+    while (m_pending > 0 && m_queued == 0) {
+        m_taskAdded.wait(&m_idleMutex);
+    }
+    --m_idleWorkers;
+}
+
+void DirectoryIndexer::push(Worker& worker, const Task& task) {
+    ++m_pending;
+    ++m_rootPending[task.root];
+    {
+        QMutexLocker locker(&worker.mutex);
+        worker.tasks.push_back(task);
+        ++m_queued;
+    }
+    if (m_idleWorkers > 0) {
+        QMutexLocker locker(&m_idleMutex);
+        m_taskAdded.wakeOne();
+    }
+}
+
+void DirectoryIndexer::finishTask(const Task& task) {
+    if (--m_rootPending[task.root] == 0) {
+        QMutexLocker locker(&m_doneMutex);
+        m_done[task.root] = true;
+        m_rootDone.wakeAll();
+    }
+    // The last task lets the waiting workers return
+    if (--m_pending == 0) {
+        QMutexLocker locker(&m_idleMutex);
+        m_taskAdded.wakeAll();
+    }
+}
+
+}
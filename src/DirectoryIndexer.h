@@ -0,0 +1,149 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <QFuture>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+#include "CatalogItem.h"
+#include "Directory.h"
+#include "DirectoryEnumerator.h"
+#include "DirectoryManifest.h"
+
+namespace launchy {
+class Catalog;
+
+// DirectoryIndexer walks the catalog directories on its own thread pool.
+// Every worker owns a deque of directories to list, it takes the newest
+// directory from its own deque and steals the oldest one, usually the root
+// of a large subtree, from another worker when it runs out. The items found
+// are staged by each worker without locking and collected per root once
+// the whole root is walked. A directory unchanged since it was recorded in
+// the manifest of the last rebuild is not listed, its items are kept.
+class DirectoryIndexer {
+public:
+    struct Item {
+        CatItem item;
+        // Pass the item to AppBase::alterItem before adding it, which is
+        // not thread safe and is left to the thread merging the items
+        bool alter;
+        // Index of the item in the manifest entry of its directory
+        int record;
+    };
+
+    // The result of walking one directory
+    struct Listing {
+        QString path;
+        // Manifest entry for the next rebuild, the keys of the items
+        // are filled in once they are added
+        DirectoryManifestEntry entry;
+        // Items to add
+        QVector<Item> items;
+        // Keys of the catalog items that are unchanged and kept
+        QVector<quint64> reused;
+    };
+
+    // The names of roots have to be expanded already, manifest is the one
+    // recorded by the last rebuild of catalog
+    DirectoryIndexer(const QList<Directory>& roots, int threadCount,
+                     const DirectoryManifest* manifest, const Catalog* catalog);
+    // Stop walking and wait for the workers
+    ~DirectoryIndexer();
+
+    // List the roots even if they are unchanged, to find the files that
+    // were modified in place, call it before start
+    void setListRoots(bool listRoots);
+    void start();
+    // Block until root is walked and return its directories, the items of
+    // one directory are in the order they are stored in the directory
+    QVector<Listing> takeListings(int root);
+    // Number of directories walked so far
+    int directoryCount() const;
+    // Number of directories skipped as unchanged so far
+    int unchangedCount() const;
+
+private:
+    // A directory to list, its subdirectories become tasks of their own
+    struct Task {
+        QString path;
+        int root;
+        int depth;
+    };
+
+    struct Worker {
+        QMutex mutex;
+        std::deque<Task> tasks;
+        // Directories walked by this worker by root, a root's list is only
+        // written by the worker and only read once the root is walked
+        std::vector<QVector<Listing>> staged;
+    };
+
+    void work(int index);
+    bool takeTask(int index, Task& task);
+    // Block until a task is queued or no task is left
+    void waitForTask();
+    void walkDirectory(Worker& worker, const Task& task);
+    // Keep the items of an unchanged directory if they are all still in the catalog
+    bool reuseEntry(const DirectoryManifestEntry& previous, Listing& listing) const;
+    void listDirectory(const Task& task, const DirectoryManifestEntry* previous, Listing& listing);
+    void push(Worker& worker, const Task& task);
+    void finishTask(const Task& task);
+
+private:
+    QList<Directory> m_roots;
+    // File types of the roots
+    QVector<NameFilter> m_filters;
+    // Hashes of the root settings, see DirectoryManifestEntry::config
+    QVector<quint32> m_configs;
+    const DirectoryManifest* m_manifest;
+    const Catalog* m_catalog;
+    bool m_listRoots;
+    // Files modified since this time, in nanoseconds since the epoch, may
+    // still change within the same tick of their clock after they are read
+    qint64 m_racyTime;
+    QThreadPool m_pool;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    QVector<QFuture<void>> m_futures;
+
+    // Tasks queued or running, in total and by root
+    std::atomic<int> m_pending;
+    // Tasks in the deques of the workers
+    std::atomic<int> m_queued;
+    std::unique_ptr<std::atomic<int>[]> m_rootPending;
+    std::atomic<int> m_directoryCount;
+    std::atomic<int> m_unchangedCount;
+    std::atomic<bool> m_canceled;
+
+    // Workers without a task wait here instead of polling the others
+    QMutex m_idleMutex;
+    QWaitCondition m_taskAdded;
+    std::atomic<int> m_idleWorkers;
+
+    QMutex m_doneMutex;
+    QWaitCondition m_rootDone;
+    QVector<bool> m_done;
+};
+
+}
@@ -0,0 +1,154 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "DirectoryManifest.h"
+
+namespace launchy {
+
+static const quint32 MANIFEST_MAGIC = 0x444d4e46; // "DMNF"
+static const quint32 MANIFEST_VERSION = 1;
+
+static QDataStream& operator<<(QDataStream& out, const DirectoryManifestItem& item) {
+    return out << item.name << item.mtime << item.key;
+}
+
+static QDataStream& operator>>(QDataStream& in, DirectoryManifestItem& item) {
+    return in >> item.name >> item.mtime >> item.key;
+}
+
+static QDataStream& operator<<(QDataStream& out, const DirectoryManifestEntry& entry) {
+    return out << entry.config << entry.mtime << entry.inode << (qint32)entry.childCount
+        << entry.subdirectories << entry.items;
+}
+
+static QDataStream& operator>>(QDataStream& in, DirectoryManifestEntry& entry) {
+    qint32 childCount = 0;
+    in >> entry.config >> entry.mtime >> entry.inode >> childCount
+        >> entry.subdirectories >> entry.items;
+    entry.childCount = childCount;
+    return in;
+}
+
+DirectoryManifestEntry::DirectoryManifestEntry()
+    : config(0),
+      mtime(-1),
+      inode(0),
+      childCount(0) {
+
+}
+
+DirectoryManifest::DirectoryManifest() {
+
+}
+
+int DirectoryManifest::count() const {
+    return m_entries.size();
+}
+
+void DirectoryManifest::clear() {
+    m_entries.clear();
+}
+
+const DirectoryManifestEntry* DirectoryManifest::find(const QString& path) const {
+    QHash<QString, DirectoryManifestEntry>::const_iterator it = m_entries.constFind(path);
+    return it != m_entries.constEnd() ? &it.value() : nullptr;
+}
+
+void DirectoryManifest::insert(const QString& path, const DirectoryManifestEntry& entry) {
+    m_entries.insert(path, entry);
+}
+
+void DirectoryManifest::takeTree(const QString& path, int depth, QVector<quint64>& keys) {
+    QHash<QString, DirectoryManifestEntry>::iterator it = m_entries.begin();
+    while (it != m_entries.end()) {
+        int level = levelBelow(path, it.key());
+        if (level < 0 || level > depth) {
+            ++it;
+            continue;
+        }
+        foreach(const DirectoryManifestItem& item, it.value().items) {
+            if (item.key != 0) {
+                keys.push_back(item.key);
+            }
+        }
+        it = m_entries.erase(it);
+    }
+}
+
+QStringList DirectoryManifest::paths() const {
+    return m_entries.keys();
+}
+
+int DirectoryManifest::levelBelow(const QString& root, const QString& path) {
+    if (path == root) {
+        return 0;
+    }
+    // A root such as "/" already ends with the separator
+    int start = root.endsWith('/') ? root.size() : root.size() + 1;
+    if (path.size() <= start || !path.startsWith(root) || path.at(start - 1) != '/') {
+        return -1;
+    }
+    return path.midRef(start).count('/') + 1;
+}
+
+bool DirectoryManifest::load(const QString& filename) {
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != MANIFEST_MAGIC || version != MANIFEST_VERSION) {
+        qWarning() << "DirectoryManifest::load, Unknown file format" << filename;
+        return false;
+    }
+
+    QHash<QString, DirectoryManifestEntry> entries;
+    in >> entries;
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "DirectoryManifest::load, Could not read" << filename;
+        return false;
+    }
+
+    m_entries.swap(entries);
+    return true;
+}
+
+bool DirectoryManifest::save(const QString& filename) const {
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("DirectoryManifest::save, Could not open manifest file for writing");
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << MANIFEST_MAGIC << MANIFEST_VERSION << m_entries;
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "DirectoryManifest::save, Could not write manifest file" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace launchy {
+
+// An entry of a catalog directory that gave a catalog item
+struct DirectoryManifestItem {
+    QString name;
+    // Modification time of a file passed to AppBase::alterItem in
+    // nanoseconds since the epoch, -1 if the item has to be found again
+    qint64 mtime;
+    // Identity key of the item, 0 if the entry gave no item
+    quint64 key;
+};
+
+// What the last rebuild found in a catalog directory
+struct DirectoryManifestEntry {
+    DirectoryManifestEntry();
+
+    // Hash of the catalog directory settings the directory was listed with
+    quint32 config;
+    // Modification time of the directory in nanoseconds since the epoch,
+    // -1 if the directory has to be listed again
+    qint64 mtime;
+    quint64 inode;
+    // Number of entries listed
+    int childCount;
+    // Subdirectories to walk, even while the directory itself is unchanged
+    QStringList subdirectories;
+    QVector<DirectoryManifestItem> items;
+};
+
+// DirectoryManifest records the modification time and the items of every
+// directory walked by a catalog rebuild. The next rebuild skips directories
+// that did not change since and keeps their items, only their subdirectories
+// are walked again.
+class DirectoryManifest {
+public:
+    DirectoryManifest();
+
+    int count() const;
+    void clear();
+    // Return the entry of the directory at the absolute path, or nullptr
+    const DirectoryManifestEntry* find(const QString& path) const;
+    void insert(const QString& path, const DirectoryManifestEntry& entry);
+    // Remove the entries of path and of the directories up to depth levels
+    // below it, append the keys of their items to keys
+    void takeTree(const QString& path, int depth, QVector<quint64>& keys);
+    // Paths of all the directories in the manifest
+    QStringList paths() const;
+
+    // Number of levels path is below root, 0 for root itself, -1 if it is not in root
+    static int levelBelow(const QString& root, const QString& path);
+
+    bool load(const QString& filename);
+    bool save(const QString& filename) const;
+
+private:
+    QHash<QString, DirectoryManifestEntry> m_entries;
+};
+
+}
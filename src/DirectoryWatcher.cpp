@@ -0,0 +1,252 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "DirectoryWatcher.h"
+#include "DirectoryEnumerator.h"
+#include "DirectoryManifest.h"
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace launchy {
+
+// Time to collect the events of a burst before reporting them, in milliseconds
+static const int FLUSH_DELAY = 1000;
+// Interval of polling the catalog directories that are not watched, in milliseconds
+static const int POLL_INTERVAL = 60 * 1000;
+
+DirectoryWatcher::DirectoryWatcher(const Callback& changed)
+    : m_changed(changed),
+      m_fd(-1) {
+#ifdef Q_OS_LINUX
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd >= 0) {
+        m_notifier.reset(new QSocketNotifier(m_fd, QSocketNotifier::Read));
+        QObject::connect(m_notifier.get(), &QSocketNotifier::activated, [this]() {
+            readEvents();
+        });
+    }
+    else {
+        qWarning() << "DirectoryWatcher::DirectoryWatcher, Could not initialize inotify"
+                   << strerror(errno);
+    }
+#endif
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FLUSH_DELAY);
+    QObject::connect(&m_flushTimer, &QTimer::timeout, [this]() {
+        flush();
+    });
+
+    m_pollTimer.setInterval(POLL_INTERVAL);
+    QObject::connect(&m_pollTimer, &QTimer::timeout, [this]() {
+        poll();
+    });
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    m_notifier.reset();
+#ifdef Q_OS_LINUX
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+#endif
+}
+
+void DirectoryWatcher::watch(const QList<Directory>& roots, const DirectoryManifest& manifest) {
+    QStringList directories = manifest.paths();
+    m_roots.clear();
+    m_polled.clear();
+    m_pollTimes.clear();
+    QSet<QString> wanted;
+    foreach(const Directory& root, roots) {
+        QString rootPath = QDir(QDir::toNativeSeparators(root.name)).absolutePath();
+        m_roots.push_back(rootPath);
+
+        // Give up the watches of a catalog directory that can not be watched
+        // completely, polling it covers all its directories anyway
+        QStringList claimed;
+        bool complete = m_fd >= 0;
+        for (int i = 0; complete && i < directories.count(); ++i) {
+            const QString& path = directories.at(i);
+            int level = DirectoryManifest::levelBelow(rootPath, path);
+            if (level < 0 || level > root.depth || wanted.contains(path)) {
+                continue;
+            }
+            if (!m_watches.contains(path)) {
+                if (!addWatch(path)) {
+                    complete = false;
+                    continue;
+                }
+            }
+            claimed.push_back(path);
+            wanted.insert(path);
+        }
+
+        if (!complete) {
+            // Watches kept from an earlier call are released as well,
+            // the descriptors they hold are what ran out
+            foreach(const QString& path, claimed) {
+                wanted.remove(path);
+                removeWatch(path);
+            }
+            m_polled.push_back(rootPath);
+            // A missing root is recorded too, to notice when it appears
+            m_pollTimes.insert(rootPath, -1);
+            foreach(const QString& path, directories) {
+                int level = DirectoryManifest::levelBelow(rootPath, path);
+                if (level >= 0 && level <= root.depth) {
+                    m_pollTimes.insert(path, manifest.find(path)->mtime);
+                }
+            }
+        }
+    }
+
+    foreach(const QString& path, m_watches.keys()) {
+        if (!wanted.contains(path)) {
+            removeWatch(path);
+        }
+    }
+
+    if (m_polled.isEmpty()) {
+        m_pollTimer.stop();
+    }
+    else if (!m_pollTimer.isActive()) {
+        m_pollTimer.start();
+    }
+    qDebug() << "DirectoryWatcher::watch, watching" << m_watches.count() << "directories, polling"
+             << m_polled.count() << "of" << m_roots.count() << "catalog directories";
+}
+
+int DirectoryWatcher::watchCount() const {
+    return m_watches.count();
+}
+
+int DirectoryWatcher::polledCount() const {
+    return m_polled.count();
+}
+
+bool DirectoryWatcher::addWatch(const QString& path) {
+#ifdef Q_OS_LINUX
+    int wd = inotify_add_watch(m_fd, QFile::encodeName(path).constData(),
+                               IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                               | IN_CLOSE_WRITE | IN_ATTRIB | IN_ONLYDIR);
+    if (wd < 0) {
+        // The directory may be gone already, the next update drops it
+        if (errno == ENOENT || errno == ENOTDIR || errno == EACCES) {
+            return true;
+        }
+        qWarning() << "DirectoryWatcher::addWatch, Could not watch" << path << strerror(errno);
+        return false;
+    }
+    m_watches.insert(path, wd);
+    m_paths.insert(wd, path);
+    return true;
+#else
+    Q_UNUSED(path)
+    return false;
+#endif
+}
+
+void DirectoryWatcher::removeWatch(const QString& path) {
+#ifdef Q_OS_LINUX
+    QHash<QString, int>::iterator it = m_watches.find(path);
+    if (it == m_watches.end()) {
+        return;
+    }
+    inotify_rm_watch(m_fd, it.value());
+    m_paths.remove(it.value());
+    m_watches.erase(it);
+#else
+    Q_UNUSED(path)
+#endif
+}
+
+void DirectoryWatcher::readEvents() {
+#ifdef Q_OS_LINUX
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    for (;;) {
+        ssize_t size = read(m_fd, buffer, sizeof(buffer));
+        if (size <= 0) {
+            break;
+        }
+
+        const char* end = buffer + size;
+        for (const char* p = buffer; p < end; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost, check every catalog directory
+                foreach(const QString& root, m_roots) {
+                    m_pending.insert(root);
+                }
+            }
+            else if (event->mask & IN_IGNORED) {
+                // The directory is gone, its parent reports it
+                m_watches.remove(m_paths.take(event->wd));
+            }
+            else if (event->len == 0 || event->name[0] != '.') {
+                // Hidden entries are never added to the catalog
+                QHash<int, QString>::const_iterator it = m_paths.constFind(event->wd);
+                if (it != m_paths.constEnd()) {
+                    m_pending.insert(it.value());
+                }
+            }
+        }
+    }
+#endif
+
+    if (!m_pending.isEmpty() && !m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void DirectoryWatcher::flush() {
+    QStringList changed = m_pending.toList();
+    m_pending.clear();
+    if (!changed.isEmpty()) {
+        m_changed(changed);
+    }
+}
+
+void DirectoryWatcher::poll() {
+    // Entries added, removed or renamed change the modification time of their
+    // directory, a new directory is found with its parent
+    QStringList changed;
+    for (QHash<QString, qint64>::iterator it = m_pollTimes.begin(); it != m_pollTimes.end(); ++it) {
+        qint64 mtime = -1;
+        quint64 inode = 0;
+        bool exists = DirectoryEnumerator::status(it.key(), mtime, inode);
+        if (exists ? it.value() < 0 || mtime != it.value() : it.value() >= 0) {
+            changed.push_back(it.key());
+            it.value() = exists ? mtime : -1;
+        }
+    }
+
+    // The callback may watch other directories, which changes m_pollTimes
+    if (!changed.isEmpty()) {
+        m_changed(changed);
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <QHash>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+#include "Directory.h"
+
+namespace launchy {
+
+class DirectoryManifest;
+
+// DirectoryWatcher reports changes to the entries of the directories walked
+// by the catalog builder. On Linux every directory is watched with inotify,
+// the events of a burst are collected and reported together. A catalog
+// directory that can not be watched completely, once the inotify watch
+// limit is reached or on other systems, is polled instead: the modification
+// times of its directories are compared with the ones the manifest recorded,
+// only the directories that changed are walked again. It lives on the
+// thread that created it.
+class DirectoryWatcher {
+public:
+    typedef std::function<void(const QStringList&)> Callback;
+
+    // changed is called with the changed directories
+    explicit DirectoryWatcher(const Callback& changed);
+    ~DirectoryWatcher();
+
+    // Watch the directories of manifest, the directories walked in the
+    // expanded catalog directories roots
+    void watch(const QList<Directory>& roots, const DirectoryManifest& manifest);
+    int watchCount() const;
+    int polledCount() const;
+
+private:
+    Q_DISABLE_COPY(DirectoryWatcher)
+
+    bool addWatch(const QString& path);
+    void removeWatch(const QString& path);
+    void readEvents();
+    void flush();
+    void poll();
+
+private:
+    Callback m_changed;
+    int m_fd;
+    std::unique_ptr<QSocketNotifier> m_notifier;
+    // Watch descriptors by path and paths by watch descriptor
+    QHash<QString, int> m_watches;
+    QHash<int, QString> m_paths;
+    QStringList m_roots;
+    // Catalog directories polled instead of watched
+    QStringList m_polled;
+    // Modification times of the directories of the polled catalog directories,
+    // -1 if the directory is missing or has to be walked again
+    QHash<QString, qint64> m_pollTimes;
+    // Changed directories not reported yet
+    QSet<QString> m_pending;
+    QTimer m_flushTimer;
+    QTimer m_pollTimer;
+};
+
+}
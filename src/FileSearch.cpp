@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "AppBase.h"
 #include "GlobalVar.h"
 #include "Catalog.h"
+#include "CatalogBuilder.h"
 #include "OptionItem.h"
 
 namespace launchy {
@@ -137,7 +138,7 @@ void FileSearch::search(const QString& searchText,
     }
     else if (sort) {
         // If we're not matching exactly and there's a filename then do a priority sort
-        qSort(searchResults.begin(), searchResults.end(), CatLessRef);
+        g_catalog->sortItems(searchResults, filePart);
     }
 
     inputData.last().setLabel(LABEL_FILE);
@@ -0,0 +1,159 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "FrecencyStore.h"
+#include <cmath>
+#include <limits>
+
+namespace launchy {
+
+static const quint32 FRECENCY_MAGIC = 0x4652434e; // "FRCN"
+// Version 2 adds the fingerprint of the rotated usage journal,
+// version 3 the usage counts of items outside the catalog
+static const quint32 FRECENCY_VERSION = 3;
+
+// Launch times are counted from 2018-01-01 so the scores stay small
+static const qint64 FRECENCY_EPOCH = 1514764800;
+
+const double FrecencyStore::HALF_LIFE = 30 * 24 * 60 * 60;
+const float FrecencyStore::NONE = -std::numeric_limits<float>::infinity();
+
+static double toHalfLives(qint64 time) {
+    return (time - FRECENCY_EPOCH) / FrecencyStore::HALF_LIFE;
+}
+
+FrecencyStore::FrecencyStore()
+    : m_baseline(toHalfLives(QDateTime::currentSecsSinceEpoch())),
+      m_journalFingerprint(0) {
+
+}
+
+void FrecencyStore::addLaunch(quint64 key, qint64 time) {
+    double launch = toHalfLives(time);
+    QHash<quint64, double>::iterator it = m_scores.find(key);
+    if (it == m_scores.end()) {
+        m_scores.insert(key, launch);
+        return;
+    }
+
+    // log2(2^a + 2^b) without leaving the log domain
+    double high = qMax(it.value(), launch);
+    double low = qMin(it.value(), launch);
+    it.value() = high + std::log2(1.0 + std::exp2(low - high));
+}
+
+void FrecencyStore::reset(quint64 key) {
+    m_scores.remove(key);
+}
+
+float FrecencyStore::score(quint64 key, int usage) const {
+    QHash<quint64, double>::const_iterator it = m_scores.constFind(key);
+    if (it != m_scores.constEnd()) {
+        return (float)it.value();
+    }
+    // Usage counted before launch times were recorded
+    if (usage > 0) {
+        return (float)(m_baseline + std::log2((double)usage));
+    }
+    return NONE;
+}
+
+int FrecencyStore::count() const {
+    return m_scores.size();
+}
+
+const QHash<quint64, int>& FrecencyStore::pendingUsage() const {
+    return m_pendingUsage;
+}
+
+void FrecencyStore::setPendingUsage(quint64 key, int usage) {
+    m_pendingUsage.insert(key, usage);
+}
+
+void FrecencyStore::removePendingUsage(quint64 key) {
+    m_pendingUsage.remove(key);
+}
+
+quint32 FrecencyStore::journalFingerprint() const {
+    return m_journalFingerprint;
+}
+
+void FrecencyStore::setJournalFingerprint(quint32 fingerprint) {
+    m_journalFingerprint = fingerprint;
+}
+
+bool FrecencyStore::load(const QString& filename) {
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != FRECENCY_MAGIC || version < 1 || version > FRECENCY_VERSION) {
+        qWarning() << "FrecencyStore::load, Unknown file format" << filename;
+        return false;
+    }
+
+    double baseline = 0;
+    quint32 journalFingerprint = 0;
+    QHash<quint64, double> scores;
+    QHash<quint64, int> pendingUsage;
+    in >> baseline;
+    if (version >= 2) {
+        in >> journalFingerprint;
+    }
+    in >> scores;
+    if (version >= 3) {
+        in >> pendingUsage;
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "FrecencyStore::load, Could not read" << filename;
+        return false;
+    }
+
+    m_baseline = baseline;
+    m_journalFingerprint = journalFingerprint;
+    m_scores.swap(scores);
+    m_pendingUsage.swap(pendingUsage);
+    return true;
+}
+
+bool FrecencyStore::save(const QString& filename) const {
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("FrecencyStore::save, Could not open frecency file for writing");
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << FRECENCY_MAGIC << FRECENCY_VERSION << m_baseline << m_journalFingerprint << m_scores
+        << m_pendingUsage;
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "FrecencyStore::save, Could not write frecency file" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+}
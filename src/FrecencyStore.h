@@ -0,0 +1,71 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+
+namespace launchy {
+
+// FrecencyStore scores items by how often and how recently they were launched.
+// Every launch adds 2^(t / HALF_LIFE) to the score of an item, where t is the
+// launch time, so a launch counts half as much as one HALF_LIFE later. Only
+// the log2 of the sum is kept, which makes a launch an O(1) update and lets
+// scores be compared without decaying them to the current time first.
+class FrecencyStore {
+public:
+    FrecencyStore();
+
+    // Record a launch of the item with the identity key at time, in seconds since the epoch
+    void addLaunch(quint64 key, qint64 time);
+    // Forget the launches of the item, e.g. when a demoted item is launched again
+    void reset(quint64 key);
+    // Return the score of the item, higher is better. Items without recorded
+    // launches are scored from usage as if launched when the store was created
+    float score(quint64 key, int usage) const;
+    int count() const;
+
+    // Usage counts of items used while they were not in the catalog, kept
+    // with the launch history until the catalog takes them over
+    const QHash<quint64, int>& pendingUsage() const;
+    void setPendingUsage(quint64 key, int usage);
+    void removePendingUsage(quint64 key);
+
+    // Fingerprint of the rotated usage journal whose launches the saved store includes
+    quint32 journalFingerprint() const;
+    void setJournalFingerprint(quint32 fingerprint);
+
+    bool load(const QString& filename);
+    bool save(const QString& filename) const;
+
+    // Seconds after which a launch counts half
+    static const double HALF_LIFE;
+    // Score of items that were never launched
+    static const float NONE;
+
+private:
+    // log2 of the sum of 2^(t / HALF_LIFE) over the launch times of an item
+    QHash<quint64, double> m_scores;
+    QHash<quint64, int> m_pendingUsage;
+    // Creation time of the store in half-lives
+    double m_baseline;
+    quint32 m_journalFingerprint;
+};
+
+}
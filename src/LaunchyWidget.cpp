@@ -52,6 +52,9 @@ namespace launchy {
 // check this page https://stackoverflow.com/questions/10755058/qflags-enum-type-conversion-fails-all-of-a-sudden
 using ::operator|;
 
+// Shortest interval of the periodic rebuild while catalog directories are watched, in minutes
+static const int WATCH_SWEEP_MINUTES = 6 * 60;
+
 LaunchyWidget* LaunchyWidget::s_instance;
 
 LaunchyWidget::LaunchyWidget(CommandFlags command)
@@ -164,12 +167,17 @@ LaunchyWidget::LaunchyWidget(CommandFlags command)
     }
 
     // Load the catalog
+    connect(g_builder, SIGNAL(catalogLoaded(bool)), this, SLOT(catalogLoaded(bool)));
     connect(g_builder, SIGNAL(catalogIncrement(int)), this, SLOT(catalogProgressUpdated(int)));
     connect(g_builder, SIGNAL(catalogFinished()), this, SLOT(catalogBuilt()));
+    connect(g_builder, SIGNAL(catalogUpdated()), this, SLOT(catalogUpdated()));
 
-    if (!g_catalog->load(SettingsManager::instance().catalogFilename())) {
-        command |= Rescan;
-    }
+    // Launches since the catalog was last saved are replayed from the journal
+    g_catalog->setFiles(SettingsManager::instance().catalogFilename(),
+                        SettingsManager::instance().frecencyFilename(),
+                        SettingsManager::instance().journalFilename());
+    // The catalog loads on the builder thread, the window is usable right away
+    QMetaObject::invokeMethod(g_builder, &CatalogBuilder::loadCatalog);
 
     // Load the history
     m_history.load(SettingsManager::instance().historyFilename());
@@ -192,7 +200,9 @@ LaunchyWidget::LaunchyWidget(CommandFlags command)
     connect(m_dropTimer, SIGNAL(timeout()), this, SLOT(dropTimeout()));
 
     m_rebuildTimer->setSingleShot(true);
-    connect(m_rebuildTimer, SIGNAL(timeout()), this, SLOT(buildCatalog()));
+    connect(m_rebuildTimer, &QTimer::timeout, [this]() {
+        buildCatalog(false);
+    });
     startRebuildTimer();
 
     // start update checker
@@ -805,7 +815,7 @@ void LaunchyWidget::searchOnInput() {
         // Search the catalog for matching items
         if (m_inputData.count() == 1) {
             qDebug() << "LaunchyWidget::searchOnInput, searching catalog for" << searchText;
-            g_catalog->searchCatalogs(searchTextLower, m_searchResult);
+            g_catalog->searchCatalogs(searchTextLower, m_searchResult, &m_searchCache);
         }
 
         if (!m_searchResult.isEmpty()) {
@@ -820,7 +830,7 @@ void LaunchyWidget::searchOnInput() {
 
         // Sort the results by match and usage, then promote any that match previously
         // executed commands
-        qSort(m_searchResult.begin(), m_searchResult.end(), CatLessRef);
+        g_catalog->sortItems(m_searchResult, searchTextLower);
         g_catalog->promoteRecentlyUsedItems(searchTextLower, m_searchResult);
 
         // Finally, if the search text looks like a file or directory name,
@@ -941,6 +951,21 @@ void LaunchyWidget::iconExtracted(int itemIndex, QString path, QIcon icon) {
     }
 }
 
+void LaunchyWidget::catalogLoaded(bool loaded) {
+    // A rescan requested at startup is already running
+    if (!loaded && !g_builder->isRunning()) {
+        buildCatalog();
+        return;
+    }
+
+    // The builder watches the catalog directories once it loaded the catalog
+    startRebuildTimer();
+
+    // Searches made while loading only saw part of the catalog
+    searchOnInput();
+    updateOutputBox();
+}
+
 void LaunchyWidget::catalogProgressUpdated(int value) {
     if (value == 0) {
         m_workingAnimation->Start();
@@ -951,12 +976,20 @@ void LaunchyWidget::catalogBuilt() {
     // Save settings and updated catalog, stop the "working" animation
     saveSettings();
     m_workingAnimation->Stop();
+    // Watching may have started or stopped with the rebuild
+    startRebuildTimer();
 
     // Now do a search using the updated catalog
     searchOnInput();
     updateOutputBox();
 }
 
+void LaunchyWidget::catalogUpdated() {
+    // Watched directories changed, the results may have new or removed items
+    searchOnInput();
+    updateOutputBox();
+}
+
 void LaunchyWidget::setSkin(const QString& name) {
     hideLaunchy(true);
     applySkin(name);
@@ -1011,12 +1044,17 @@ void LaunchyWidget::saveSettings() {
     qDebug() << "LaunchyWidget::saveSettings";
     savePosition();
     g_settings->sync();
-    g_catalog->save(SettingsManager::instance().catalogFilename());
+    g_catalog->saveInBackground(SettingsManager::instance().catalogFilename());
     m_history.save(SettingsManager::instance().historyFilename());
 }
 
 void LaunchyWidget::startRebuildTimer() {
     int time = g_settings->value(OPTION_REBUILDTIMER, OPTION_REBUILDTIMER_DEFAULT).toInt();
+    // Changes in watched directories are applied as they happen,
+    // the rebuild is only a sweep for what the watcher missed
+    if (time > 0 && g_builder->isWatching()) {
+        time = qMax(time, WATCH_SWEEP_MINUTES);
+    }
     if (time > 0) {
         m_rebuildTimer->start(time * 60000);
     }
@@ -1087,7 +1125,10 @@ void LaunchyWidget::reloadSkin() {
 void LaunchyWidget::exit() {
     m_trayIcon->hide();
     m_fader->stop();
+    // An exit right after starting saves the loaded catalog, not the empty one
+    g_catalog->waitForLoad();
     saveSettings();
+    g_catalog->waitForSave();
     qApp->quit();
 }
 
@@ -1273,12 +1314,14 @@ void LaunchyWidget::trayIconActivated(QSystemTrayIcon::ActivationReason reason)
     }
 }
 
-void LaunchyWidget::buildCatalog() {
+void LaunchyWidget::buildCatalog(bool full) {
     m_rebuildTimer->stop();
     saveSettings();
 
     // Use the catalog builder to refresh the catalog in a worker thread
-    QMetaObject::invokeMethod(g_builder, &CatalogBuilder::buildCatalog);
+    QMetaObject::invokeMethod(g_builder, [full]() {
+        g_builder->buildCatalog(full);
+    });
 
     startRebuildTimer();
 }
@@ -24,6 +24,7 @@
 #include "IconExtractor.h"
 #include "InputData.h"
 #include "CommandHistory.h"
+#include "Catalog.h"
 
 class QSystemTrayIcon;
 class QPushButton;
@@ -70,7 +71,8 @@ public:
 
 public slots:
     void showLaunchy(bool noFade = false);
-    void buildCatalog();
+    // Rebuilds from the timer skip the directories that did not change
+    void buildCatalog(bool full = true);
     void setOpaqueness(int level);
 
 protected:
@@ -114,8 +116,10 @@ protected slots:
     void showOptionDialog();
     void onHotkey();
     void dropTimeout();
+    void catalogLoaded(bool loaded);
     void catalogProgressUpdated(int);
     void catalogBuilt();
+    void catalogUpdated();
     void setFadeLevel(double level);
     void iconExtracted(int index, QString path, QIcon icon);
     void trayIconActivated(QSystemTrayIcon::ActivationReason reason);
@@ -169,6 +173,8 @@ protected:
     InputDataList m_inputData;
     CommandHistory m_history;
     QList<CatItem> m_searchResult;
+    // Catalog matches of the previous keystrokes, reused while the input is extended
+    CatalogSearchCache m_searchCache;
     CatItem m_outputItem;
     bool m_alwaysShowLaunchy;
 
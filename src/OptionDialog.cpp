@@ -51,7 +51,8 @@ int OptionDialog::s_lastPlugin = -1;
 OptionDialog::OptionDialog(QWidget* parent)
     : QDialog(parent),
       m_pUi(new Ui::OptionDialog),
-      m_directoryItemDelegate(new FileBrowserDelegate(this, FileBrowser::Directory)) {
+      m_directoryItemDelegate(new FileBrowserDelegate(this, FileBrowser::Directory)),
+      m_purged(-1) {
 
     setObjectName("options");
     g_needRebuildCatalog.storeRelease(0);
@@ -89,6 +90,7 @@ OptionDialog::OptionDialog(QWidget* parent)
 OptionDialog::~OptionDialog() {
     if (g_builder) {
         disconnect(g_builder, SIGNAL(catalogIncrement(int)), this, SLOT(catalogProgressUpdated(int)));
+        disconnect(g_builder, SIGNAL(catalogPurged(int, int)), this, SLOT(catalogPurged(int, int)));
         disconnect(g_builder, SIGNAL(catalogFinished()), this, SLOT(catalogBuilt()));
     }
 
@@ -397,11 +399,21 @@ void OptionDialog::catalogProgressUpdated(int value) {
     m_pUi->catRescan->setEnabled(false);
 }
 
+void OptionDialog::catalogPurged(int purged, int milliseconds) {
+    Q_UNUSED(milliseconds)
+    m_purged = purged;
+}
+
 void OptionDialog::catalogBuilt() {
     m_pUi->catProgress->setVisible(false);
     m_pUi->catRescan->setEnabled(true);
 
-    m_pUi->catSize->setText(tr("Index has %n item(s)", "", g_catalog->count()));
+    QString size = tr("Index has %n item(s)", "", g_catalog->count());
+    // The rebuild emits the purge before it finishes
+    if (m_purged >= 0) {
+        size += tr(", %n removed", "", m_purged);
+    }
+    m_pUi->catSize->setText(size);
     m_pUi->catSize->setVisible(true);
 }
 
@@ -760,6 +772,7 @@ void OptionDialog::initCatalogWidget() {
 
     m_pUi->catProgress->setVisible(false);
     connect(g_builder, SIGNAL(catalogIncrement(int)), this, SLOT(catalogProgressUpdated(int)));
+    connect(g_builder, SIGNAL(catalogPurged(int, int)), this, SLOT(catalogPurged(int, int)));
     connect(g_builder, SIGNAL(catalogFinished()), this, SLOT(catalogBuilt()));
     if (g_builder->isRunning()) {
         catalogProgressUpdated(g_builder->getProgress());
@@ -94,6 +94,7 @@ private slots:
     void catTypesExeChanged(int);
     void catDepthChanged(int);
     void catalogProgressUpdated(int);
+    void catalogPurged(int purged, int milliseconds);
     void catalogBuilt();
     void catRescanClicked(bool);
     // plugins
@@ -116,6 +117,8 @@ private:
     QList<int> m_iMetaKeys;
     QList<int> m_iActionKeys;
     QList<Directory> m_memDirs;
+    // Items removed by the last rebuild, -1 before a rebuild finished
+    int m_purged;
 
     //QList<QPair<QString, uint>> pluginNames;
     //QVBoxLayout* pluginLayout;
@@ -57,6 +57,24 @@ const int       OPSTION_AUTOSUGGESTDELAY_DEFAULT               = 1000;
 const char*     OPTION_REBUILDTIMER                           = "GenOps/rebuildTimer";
 const int       OPTION_REBUILDTIMER_DEFAULT                   = 30;
 
+const char*     OPTION_FASTCATALOG                            = "GenOps/fastCatalog";
+const bool      OPTION_FASTCATALOG_DEFAULT                    = false;
+
+const char*     OPTION_PARALLELSEARCH                         = "GenOps/parallelSearchThreshold";
+const int       OPTION_PARALLELSEARCH_DEFAULT                 = 20000;
+
+const char*     OPTION_SYNCJOURNAL                            = "GenOps/syncUsageJournal";
+const bool      OPTION_SYNCJOURNAL_DEFAULT                    = false;
+
+const char*     OPTION_MEMORYBUDGET                           = "GenOps/catalogMemoryBudget";
+const int       OPTION_MEMORYBUDGET_DEFAULT                   = 0;
+
+const char*     OPTION_INDEXTHREADS                           = "GenOps/indexThreads";
+const int       OPTION_INDEXTHREADS_DEFAULT                   = 0;
+
+const char*     OPTION_WATCHDIRECTORIES                       = "GenOps/watchDirectories";
+const bool      OPTION_WATCHDIRECTORIES_DEFAULT               = true;
+
 const char*     OPSTION_NUMVIEWABLE                            = "GenOps/numviewable";
 const int       OPSTION_NUMVIEWABLE_DEFAULT                    = 4;
 
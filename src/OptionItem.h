@@ -127,6 +127,24 @@ extern const bool       OPTION_SHOWHIDDENFILES_DEFAULT;
 extern const char*      OPTION_SHOWNETWORK;
 extern const bool       OPTION_SHOWNETWORK_DEFAULT;
 
+extern const char*      OPTION_FASTCATALOG;
+extern const bool       OPTION_FASTCATALOG_DEFAULT;
+
+extern const char*      OPTION_PARALLELSEARCH;
+extern const int        OPTION_PARALLELSEARCH_DEFAULT;
+
+extern const char*      OPTION_SYNCJOURNAL;
+extern const bool       OPTION_SYNCJOURNAL_DEFAULT;
+
+extern const char*      OPTION_MEMORYBUDGET;
+extern const int        OPTION_MEMORYBUDGET_DEFAULT;
+
+extern const char*      OPTION_INDEXTHREADS;
+extern const int        OPTION_INDEXTHREADS_DEFAULT;
+
+extern const char*      OPTION_WATCHDIRECTORIES;
+extern const bool       OPTION_WATCHDIRECTORIES_DEFAULT;
+
 extern const char*      OPTION_LOGLEVEL;
 extern const int        OPTION_LOGLEVEL_DEFAULT;
 
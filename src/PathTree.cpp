@@ -0,0 +1,159 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "PathTree.h"
+
+namespace launchy {
+
+static const QChar SEPARATOR('/');
+
+PathTree::PathTree()
+    : m_lastNode(-1) {
+
+}
+
+int PathTree::count() const {
+    return m_nodes.size();
+}
+
+qint64 PathTree::memoryUsage() const {
+    return (qint64)m_names.capacity() * sizeof(QChar)
+        + (qint64)m_nodes.capacity() * sizeof(Node)
+        + (qint64)m_buckets.capacity() * sizeof(int);
+}
+
+void PathTree::clear() {
+    m_names.clear();
+    m_nodes.clear();
+    m_buckets.clear();
+    m_lastPath.clear();
+    m_lastNode = -1;
+}
+
+int PathTree::insert(const QChar* path, int length) {
+    if (m_lastNode >= 0 && m_lastPath.size() == length
+        && memcmp(m_lastPath.constData(), path, length * sizeof(QChar)) == 0) {
+        return m_lastNode;
+    }
+
+    int node = -1;
+    int begin = 0;
+    for (int i = 0; i <= length; ++i) {
+        if (i == length || path[i] == SEPARATOR) {
+            node = findOrAdd(node, path + begin, i - begin);
+            begin = i + 1;
+        }
+    }
+
+    m_lastPath = QString(path, length);
+    m_lastNode = node;
+    return node;
+}
+
+int PathTree::length(int node) const {
+    return m_nodes.at(node).pathLength;
+}
+
+void PathTree::copyPath(int node, QChar* dst) const {
+    // Fill from the last component backwards
+    QChar* end = dst + m_nodes.at(node).pathLength;
+    for (;;) {
+        const Node& n = m_nodes.at(node);
+        end -= n.length;
+        memcpy(end, m_names.constData() + n.offset, n.length * sizeof(QChar));
+        node = n.parent;
+        if (node < 0) {
+            break;
+        }
+        *--end = SEPARATOR;
+    }
+}
+
+QString PathTree::path(int node) const {
+    QString result(length(node), Qt::Uninitialized);
+    copyPath(node, result.data());
+    return result;
+}
+
+bool PathTree::equals(int node, const QChar* path, int length) const {
+    if (m_nodes.at(node).pathLength != length) {
+        return false;
+    }
+
+    int end = length;
+    for (;;) {
+        const Node& n = m_nodes.at(node);
+        end -= n.length;
+        if (memcmp(path + end, m_names.constData() + n.offset, n.length * sizeof(QChar)) != 0) {
+            return false;
+        }
+        node = n.parent;
+        if (node < 0) {
+            return true;
+        }
+        if (path[--end] != SEPARATOR) {
+            return false;
+        }
+    }
+}
+
+int PathTree::findOrAdd(int parent, const QChar* name, int length) {
+    if ((m_nodes.size() + 1) * 2 > m_buckets.size()) {
+        grow();
+    }
+
+    uint hash = qHashBits(name, length * sizeof(QChar), (uint)(parent + 1));
+    int mask = m_buckets.size() - 1;
+    for (int i = hash & mask; ; i = (i + 1) & mask) {
+        int index = m_buckets.at(i);
+        if (index < 0) {
+            Node node;
+            node.parent = parent;
+            node.hash = hash;
+            node.offset = m_names.size();
+            node.length = length;
+            node.pathLength = parent >= 0 ? m_nodes.at(parent).pathLength + 1 + length : length;
+            m_names.append(name, length);
+            m_nodes.push_back(node);
+            m_buckets[i] = m_nodes.size() - 1;
+            return m_nodes.size() - 1;
+        }
+
+        const Node& node = m_nodes.at(index);
+        if (node.hash == hash && node.parent == parent && node.length == length
+            && memcmp(m_names.constData() + node.offset, name, length * sizeof(QChar)) == 0) {
+            return index;
+        }
+    }
+}
+
+void PathTree::grow() {
+    int size = qMax(64, m_buckets.size() * 2);
+    m_buckets.fill(-1, size);
+    int mask = size - 1;
+    for (int index = 0; index < m_nodes.size(); ++index) {
+        int i = m_nodes.at(index).hash & mask;
+        while (m_buckets.at(i) >= 0) {
+            i = (i + 1) & mask;
+        }
+        m_buckets[i] = index;
+    }
+}
+
+}
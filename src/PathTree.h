@@ -0,0 +1,74 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+namespace launchy {
+
+// PathTree interns directory paths. A path is split at every '/' into
+// components, each node holds one component and points to the node of its
+// parent directory, so directories shared by many items are stored once.
+// Splitting and joining at '/' is lossless, paths of any form can be stored.
+class PathTree {
+public:
+    PathTree();
+
+    int count() const;
+    void clear();
+    // Approximate heap memory used by the tree in bytes
+    qint64 memoryUsage() const;
+
+    // Return the node of path, adding the nodes that do not exist yet
+    int insert(const QChar* path, int length);
+    // Length of the path of node
+    int length(int node) const;
+    // Write the path of node to dst, which has room for length(node) characters
+    void copyPath(int node, QChar* dst) const;
+    QString path(int node) const;
+    // Return true if path is the path of node, without building it
+    bool equals(int node, const QChar* path, int length) const;
+
+private:
+    struct Node {
+        int parent;
+        uint hash;
+        // Component name in m_names
+        int offset;
+        int length;
+        // Length of the whole path up to and including this component
+        int pathLength;
+    };
+
+    int findOrAdd(int parent, const QChar* name, int length);
+    void grow();
+
+private:
+    QString m_names;
+    QVector<Node> m_nodes;
+    // Open addressing table of node indexes, -1 for empty buckets
+    QVector<int> m_buckets;
+
+    // Items are mostly added directory by directory
+    QString m_lastPath;
+    int m_lastNode;
+};
+
+}
@@ -25,10 +25,15 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "Logger.h"
 #include "OptionItem.h"
 #include "TranslationManager.h"
+#include "CatalogBuilder.h"
+#include "UsageJournal.h"
 
 static const char* iniName = "/launchy.ini";
 static const char* dbName = "/launchy.db";
 static const char* historyName = "/history.db";
+static const char* frecencyName = "/frecency.db";
+static const char* journalName = "/usage.journal";
+static const char* manifestName = "/manifest.db";
 
 // for QNetworkProxy::ProxyType in QVariant
 Q_DECLARE_METATYPE(QNetworkProxy::ProxyType)
@@ -123,6 +128,18 @@ QString SettingsManager::historyFilename() const {
     return configDirectory(m_portable) + historyName;
 }
 
+QString SettingsManager::frecencyFilename() const {
+    return configDirectory(m_portable) + frecencyName;
+}
+
+QString SettingsManager::journalFilename() const {
+    return configDirectory(m_portable) + journalName;
+}
+
+QString SettingsManager::manifestFilename() const {
+    return configDirectory(m_portable) + manifestName;
+}
+
 // Find the skin with the specified name ensuring that it contains at least a stylesheet
 QString SettingsManager::skinPath(const QString& skinName) const {
     QString directory;
@@ -149,11 +166,16 @@ void SettingsManager::setPortable(bool makePortable) {
 
     // Destroy the QSettings object first so it writes every changes to disk
     g_settings.clear();
+    // Close the usage journal and stop background saves so the files can be moved
+    g_catalog->setFiles(QString(), QString(), QString());
+    g_catalog->waitForSave();
 
     QString oldDir = configDirectory(m_portable);
     QString oldIniName = oldDir + iniName;
     QString oldDbName = oldDir + dbName;
     QString oldHistoryName = oldDir + historyName;
+    QString oldFrecencyName = oldDir + frecencyName;
+    QString oldJournalName = oldDir + journalName;
 
     // Copy the settings to the new location
     // and delete the original settings if they are copied successfully
@@ -166,6 +188,20 @@ void SettingsManager::setPortable(bool makePortable) {
         QFile::remove(oldDbName);
         QFile::remove(oldHistoryName);
 
+        // The launch history is only written once something was launched
+        if (QFile::copy(oldFrecencyName, newDir + frecencyName)) {
+            QFile::remove(oldFrecencyName);
+        }
+        QString oldRotatedName = UsageJournal::rotatedFilename(oldJournalName);
+        if (QFile::copy(oldJournalName, newDir + journalName)) {
+            QFile::remove(oldJournalName);
+        }
+        if (QFile::copy(oldRotatedName, UsageJournal::rotatedFilename(newDir + journalName))) {
+            QFile::remove(oldRotatedName);
+        }
+        // The next rebuild records the directories again
+        QFile::remove(oldDir + manifestName);
+
         if (!makePortable) {
             // if converting to installed mode,
             // try to remove portable mode config directory if it is empty.
@@ -186,6 +222,7 @@ void SettingsManager::setPortable(bool makePortable) {
     }
 
     load();
+    g_catalog->setFiles(catalogFilename(), frecencyFilename(), journalFilename());
 }
 
 // Delete all settings files in both installed and portable directories
@@ -193,10 +230,18 @@ void SettingsManager::removeAll() {
     QFile::remove(configDirectory(false) + iniName);
     QFile::remove(configDirectory(false) + dbName);
     QFile::remove(configDirectory(false) + historyName);
+    QFile::remove(configDirectory(false) + frecencyName);
+    QFile::remove(configDirectory(false) + journalName);
+    QFile::remove(UsageJournal::rotatedFilename(configDirectory(false) + journalName));
+    QFile::remove(configDirectory(false) + manifestName);
 
     QFile::remove(configDirectory(true) + iniName);
     QFile::remove(configDirectory(true) + dbName);
     QFile::remove(configDirectory(true) + historyName);
+    QFile::remove(configDirectory(true) + frecencyName);
+    QFile::remove(configDirectory(true) + journalName);
+    QFile::remove(UsageJournal::rotatedFilename(configDirectory(true) + journalName));
+    QFile::remove(configDirectory(true) + manifestName);
 }
 
 // Get the configuration directory
@@ -36,6 +36,9 @@ public:
     QList<QString> directory(QString name) const;
     QString catalogFilename() const;
     QString historyFilename() const;
+    QString frecencyFilename() const;
+    QString journalFilename() const;
+    QString manifestFilename() const;
     QString skinPath(const QString& skinName) const;
     void setPortable(bool makePortable);
     void removeAll();
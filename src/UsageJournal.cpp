@@ -0,0 +1,202 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "UsageJournal.h"
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace launchy {
+
+static const qint64 RECORD_SIZE = sizeof(UsageJournalRecord);
+
+// Drop a record cut short at the end of file, appending after it would
+// misalign all the following records
+static void truncateToRecords(QFile& file) {
+    qint64 size = file.size();
+    if (size % RECORD_SIZE != 0) {
+        file.resize(size - size % RECORD_SIZE);
+    }
+}
+
+UsageJournal::UsageJournal()
+    : m_count(0) {
+
+}
+
+UsageJournal::~UsageJournal() {
+    close();
+}
+
+bool UsageJournal::open(const QString& filename) {
+    close();
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "UsageJournal::open, Could not open" << filename << m_file.errorString();
+        return false;
+    }
+    truncateToRecords(m_file);
+    m_count = (int)(m_file.size() / RECORD_SIZE);
+    return true;
+}
+
+void UsageJournal::close() {
+    m_file.close();
+    m_count = 0;
+}
+
+bool UsageJournal::isOpen() const {
+    return m_file.isOpen();
+}
+
+int UsageJournal::count() const {
+    return m_count;
+}
+
+bool UsageJournal::append(quint64 key, UsageJournalRecord::Operation operation, qint64 time,
+                          bool sync) {
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    UsageJournalRecord record;
+    record.key = key;
+    record.time = time;
+    record.operation = operation;
+    record.check = makeCheck(record);
+    if (m_file.write(reinterpret_cast<const char*>(&record), RECORD_SIZE) != RECORD_SIZE
+        || !m_file.flush()) {
+        qWarning() << "UsageJournal::append, Could not write journal" << m_file.errorString();
+        return false;
+    }
+
+    if (sync) {
+#ifdef Q_OS_WIN
+        _commit(m_file.handle());
+#else
+        fsync(m_file.handle());
+#endif
+    }
+
+    ++m_count;
+    return true;
+}
+
+bool UsageJournal::rotate() {
+    if (!m_file.isOpen()) {
+        return false;
+    }
+
+    QString filename = m_file.fileName();
+    QString rotated = rotatedFilename(filename);
+    close();
+
+    bool success = true;
+    if (QFile::exists(rotated)) {
+        // An earlier save did not complete, its records stay in front
+        QFile in(filename);
+        QFile out(rotated);
+        if (in.open(QIODevice::ReadOnly) && out.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            truncateToRecords(out);
+            success = out.write(in.readAll()) >= 0;
+            in.close();
+            out.close();
+            if (success) {
+                QFile::remove(filename);
+            }
+        }
+        else {
+            success = false;
+        }
+    }
+    else {
+        success = QFile::rename(filename, rotated);
+    }
+    if (!success) {
+        qWarning() << "UsageJournal::rotate, Could not rotate" << filename;
+    }
+
+    return open(filename) && success;
+}
+
+void UsageJournal::removeRotated() {
+    QFile::remove(rotatedFilename(m_file.fileName()));
+}
+
+quint32 UsageJournal::rotatedFingerprint() const {
+    QVector<UsageJournalRecord> records;
+    readFile(rotatedFilename(m_file.fileName()), records);
+    return fingerprint(records);
+}
+
+bool UsageJournal::read(const QString& filename, QVector<UsageJournalRecord>& rotated,
+                        QVector<UsageJournalRecord>& records) {
+    bool hasRotated = readFile(rotatedFilename(filename), rotated);
+    bool hasCurrent = readFile(filename, records);
+    return hasRotated || hasCurrent;
+}
+
+QString UsageJournal::rotatedFilename(const QString& filename) {
+    return filename + ".old";
+}
+
+quint32 UsageJournal::fingerprint(const QVector<UsageJournalRecord>& records) {
+    // FNV-1a over the checks, which already mix every field of a record
+    quint32 hash = 2166136261u ^ (quint32)records.size();
+    foreach(const UsageJournalRecord& record, records) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash = (hash ^ ((record.check >> shift) & 0xff)) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+quint32 UsageJournal::makeCheck(const UsageJournalRecord& record) {
+    quint64 mixed = record.key ^ (quint64)record.time * Q_UINT64_C(0x9e3779b97f4a7c15)
+        ^ record.operation;
+    return ~(quint32)(mixed ^ (mixed >> 32));
+}
+
+bool UsageJournal::readFile(const QString& filename, QVector<UsageJournalRecord>& records) {
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QByteArray data = file.readAll();
+    int count = (int)(data.size() / RECORD_SIZE);
+    const UsageJournalRecord* begin = reinterpret_cast<const UsageJournalRecord*>(data.constData());
+    for (int i = 0; i < count; ++i) {
+        UsageJournalRecord record;
+        memcpy(&record, begin + i, RECORD_SIZE);
+        if (record.check != makeCheck(record)
+            || (record.operation != UsageJournalRecord::Launch
+                && record.operation != UsageJournalRecord::Demote)) {
+            qWarning() << "UsageJournal::read, Ignoring damaged records from" << i << "in" << filename;
+            break;
+        }
+        records.push_back(record);
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QFile>
+#include <QVector>
+
+namespace launchy {
+
+/*
+  Usage journal layout, all values are stored in native byte order
+
+  UsageJournalRecord[]
+
+  A record is appended for every launch and demotion. A record cut short
+  by a crash fails its check and ends the journal.
+
+  The catalog and the launch history store the fingerprint of the rotated
+  journal whose records they include, so a rotated journal left behind by
+  a crash after they were saved is not replayed a second time.
+*/
+
+struct UsageJournalRecord {
+    enum Operation {
+        Launch = 1,
+        Demote = 2
+    };
+
+    // Identity key of the item, see CatalogStore::makeKey
+    quint64 key;
+    // Seconds since the epoch
+    qint64 time;
+    quint32 operation;
+    quint32 check;
+};
+
+// UsageJournal appends usage changes to a small file instead of rewriting
+// the catalog. While the catalog is saved the journal is rotated, so new
+// records go to an empty journal and the rotated one is removed once the
+// saved catalog contains its changes.
+class UsageJournal {
+public:
+    UsageJournal();
+    ~UsageJournal();
+
+    // Open filename for appending, creating it if necessary
+    bool open(const QString& filename);
+    void close();
+    bool isOpen() const;
+    // Number of records in the journal
+    int count() const;
+
+    // Append a record, flushed to the disk as well when sync is set
+    bool append(quint64 key, UsageJournalRecord::Operation operation, qint64 time, bool sync);
+
+    // Move the records to the rotated journal and continue with an empty one
+    bool rotate();
+    // Remove the rotated journal after its records were saved elsewhere
+    void removeRotated();
+    // Fingerprint of the records of the rotated journal
+    quint32 rotatedFingerprint() const;
+
+    // Read the records of the rotated journal and of the journal,
+    // the journal does not have to be open
+    static bool read(const QString& filename, QVector<UsageJournalRecord>& rotated,
+                     QVector<UsageJournalRecord>& records);
+    static QString rotatedFilename(const QString& filename);
+    // Identify a list of records by their checks
+    static quint32 fingerprint(const QVector<UsageJournalRecord>& records);
+
+private:
+    static quint32 makeCheck(const UsageJournalRecord& record);
+    static bool readFile(const QString& filename, QVector<UsageJournalRecord>& records);
+
+private:
+    QFile m_file;
+    int m_count;
+};
+
+}
@@ -0,0 +1,99 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchAlloc.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<qint64> s_allocations(0);
+static std::atomic<qint64> s_allocatedBytes(0);
+
+static void countAllocation(size_t size) {
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    s_allocatedBytes.fetch_add((qint64)size, std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+
+// glibc exports its allocator under these names, the definitions below
+// take the place of malloc for Qt and the C++ runtime as well
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) {
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    countAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+}
+
+static const char* ALLOCATION_SOURCE = "malloc";
+
+#else
+
+void* operator new(size_t size) {
+    countAllocation(size);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+static const char* ALLOCATION_SOURCE = "operator new";
+
+#endif
+
+namespace launchy {
+
+qint64 benchAllocations() {
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+qint64 benchAllocatedBytes() {
+    return s_allocatedBytes.load(std::memory_order_relaxed);
+}
+
+const char* benchAllocationSource() {
+    return ALLOCATION_SOURCE;
+}
+
+}
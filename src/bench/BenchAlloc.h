@@ -0,0 +1,34 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QtGlobal>
+
+namespace launchy {
+
+// Heap allocations made by the whole process since it started, counted by
+// hooking the allocator. Reading them before and after an operation gives
+// the allocations of the operation as long as no other work is running
+qint64 benchAllocations();
+qint64 benchAllocatedBytes();
+// The allocator calls that are counted, "malloc" where the C allocator can
+// be hooked, otherwise "operator new" which misses Qt's container storage
+const char* benchAllocationSource();
+
+}
@@ -0,0 +1,219 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchCorpus.h"
+
+namespace launchy {
+
+// Separate random streams for items, directories, usage and keystrokes
+static const quint64 ITEM_STREAM = 0;
+static const quint64 DIRECTORY_STREAM = Q_UINT64_C(1) << 40;
+static const quint64 USAGE_STREAM = Q_UINT64_C(2) << 40;
+static const quint64 KEYSTROKE_STREAM = Q_UINT64_C(3) << 40;
+
+// Items per directory on average
+static const int DIRECTORY_SIZE = 40;
+// Characters typed at most for a prefix search
+static const int MAX_TYPED = 8;
+
+static const char* const SYLLABLES[] = {
+    "ad", "al", "an", "ar", "ba", "be", "bo", "ca", "ci", "co", "da", "de", "di", "do",
+    "ed", "el", "en", "er", "fa", "fi", "fo", "ga", "ge", "go", "ha", "he", "hi", "in",
+    "is", "ja", "ka", "ke", "la", "le", "li", "lo", "ma", "me", "mi", "mo", "na", "ne",
+    "ni", "no", "on", "or", "pa", "pe", "pi", "po", "qu", "ra", "re", "ri", "ro", "sa",
+    "se", "si", "so", "ta", "te", "ti", "to", "un", "ur", "va", "ve", "vi", "vo", "wa",
+    "we", "xa", "yo", "za", "ze", "zo", "ch", "ck", "ght", "ng", "ph", "sh", "str", "th"
+};
+
+static const char* const ROOTS[] = {
+    "C:/Program Files",
+    "C:/ProgramData/Microsoft/Windows/Start Menu/Programs",
+    "C:/Users/bench/Documents",
+    "/usr/share/applications",
+    "/opt",
+    "/home/bench/projects"
+};
+
+static const char* const EXTENSIONS[] = {
+    ".lnk", ".exe", ".desktop", ".url", ""
+};
+
+// The CJK unified ideographs transliterated to pinyin
+static const int CJK_FIRST = 0x4e00;
+static const int CJK_LAST = 0x9fa5;
+
+// SplitMix64, fully specified so a corpus does not depend on the standard library
+class BenchRandom {
+public:
+    BenchRandom(quint32 seed, quint64 stream)
+        : m_state(((quint64)seed << 32 | seed) ^ stream * Q_UINT64_C(0xd1342543de82ef95)) {
+    }
+
+    quint32 next() {
+        quint64 z = (m_state += Q_UINT64_C(0x9e3779b97f4a7c15));
+        z = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+        z = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+        return (quint32)((z ^ (z >> 31)) >> 32);
+    }
+
+    // Uniform enough in [0, n) for the small n used here
+    int bounded(int n) {
+        return (int)(next() % (quint32)n);
+    }
+
+private:
+    quint64 m_state;
+};
+
+template <typename T, int N>
+static int countOf(T (&)[N]) {
+    return N;
+}
+
+static QString word(BenchRandom& random, bool capitalize) {
+    QString result;
+    int syllables = 1 + random.bounded(4);
+    for (int i = 0; i < syllables; ++i) {
+        result += QLatin1String(SYLLABLES[random.bounded(countOf(SYLLABLES))]);
+    }
+    if (capitalize) {
+        result[0] = result.at(0).toUpper();
+    }
+    return result;
+}
+
+BenchCorpus::BenchCorpus(Script script, int size, quint32 seed)
+    : m_script(script),
+      m_size(size),
+      m_seed(seed) {
+
+}
+
+int BenchCorpus::size() const {
+    return m_size;
+}
+
+QString BenchCorpus::name() const {
+    return QString("%1-%2").arg(m_script == Ascii ? "ascii" : "cjk").arg(m_size);
+}
+
+void BenchCorpus::item(int index, QString& fullPath, QString& shortName) const {
+    BenchRandom random(m_seed, ITEM_STREAM + index);
+    int directories = qMax(1, m_size / DIRECTORY_SIZE);
+    QString dir = directory(random.bounded(directories));
+
+    shortName.clear();
+    if (m_script == Ascii) {
+        int words = 1 + random.bounded(3);
+        for (int i = 0; i < words; ++i) {
+            if (i > 0) {
+                shortName += QLatin1Char(' ');
+            }
+            shortName += word(random, true);
+        }
+        if (random.bounded(100) < 15) {
+            shortName += QLatin1Char(' ') + QString::number(1 + random.bounded(20));
+        }
+    }
+    else {
+        int chars = 2 + random.bounded(4);
+        for (int i = 0; i < chars; ++i) {
+            shortName += QChar(CJK_FIRST + random.bounded(CJK_LAST - CJK_FIRST + 1));
+        }
+        // Mixed names such as product names with a Latin suffix
+        if (random.bounded(100) < 20) {
+            shortName += QLatin1Char(' ') + word(random, true);
+        }
+    }
+
+    fullPath = dir + QLatin1Char('/') + shortName
+        + QLatin1String(EXTENSIONS[random.bounded(countOf(EXTENSIONS))]);
+}
+
+int BenchCorpus::usage(int index) const {
+    BenchRandom random(m_seed, USAGE_STREAM + index);
+    int bucket = random.bounded(100);
+    if (bucket < 89) {
+        return 0;
+    }
+    if (bucket < 90) {
+        return -1 - random.bounded(3);
+    }
+    if (bucket < 99) {
+        return 1 + random.bounded(5);
+    }
+    return 10 + random.bounded(200);
+}
+
+CatItem BenchCorpus::catItem(int index) const {
+    QString fullPath;
+    QString shortName;
+    item(index, fullPath, shortName);
+    CatItem result(fullPath, shortName);
+    result.usage = usage(index);
+    return result;
+}
+
+QList<QStringList> BenchCorpus::keystrokes(int count) const {
+    BenchRandom random(m_seed, KEYSTROKE_STREAM);
+    QList<QStringList> sequences;
+    for (int i = 0; i < count; ++i) {
+        // Chinese names are typed as pinyin
+        CatItem target = catItem(random.bounded(m_size));
+        QString name = target.searchName[m_script == Ascii ? CatItem::LOWER : CatItem::TRANS];
+
+        QString typed;
+        int mode = random.bounded(10);
+        if (mode < 6 || (mode < 9 && m_script != Ascii)) {
+            // The beginning of the name
+            typed = name.left(1 + random.bounded(qMin(MAX_TYPED, name.size())));
+        }
+        else if (mode < 9) {
+            // The initials of the words, e.g. "vsc" for "visual studio code"
+            foreach(const QString& part, name.split(QLatin1Char(' '), QString::SkipEmptyParts)) {
+                typed += part.at(0);
+            }
+        }
+        else {
+            // Letters matching anything or nothing
+            int length = 1 + random.bounded(3);
+            for (int j = 0; j < length; ++j) {
+                typed += QChar('a' + random.bounded(26));
+            }
+        }
+
+        QStringList sequence;
+        for (int length = 1; length <= typed.size(); ++length) {
+            sequence.push_back(typed.left(length));
+        }
+        sequences.push_back(sequence);
+    }
+    return sequences;
+}
+
+QString BenchCorpus::directory(int index) const {
+    BenchRandom random(m_seed, DIRECTORY_STREAM + index);
+    QString result = QLatin1String(ROOTS[random.bounded(countOf(ROOTS))]);
+    int depth = 1 + random.bounded(3);
+    for (int i = 0; i < depth; ++i) {
+        result += QLatin1Char('/') + word(random, i == 0);
+    }
+    return result;
+}
+
+}
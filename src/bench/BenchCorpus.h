@@ -0,0 +1,64 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "CatalogItem.h"
+
+namespace launchy {
+
+// BenchCorpus generates a synthetic catalog. Every item is derived from the
+// seed and its index only, so a corpus is the same on every run and platform
+// and items are generated on demand instead of being held in memory.
+class BenchCorpus {
+public:
+    enum Script {
+        // Names of English like words, searched by their letters
+        Ascii,
+        // Names of Chinese characters, searched by their pinyin
+        Cjk
+    };
+
+    BenchCorpus(Script script, int size, quint32 seed);
+
+    int size() const;
+    // Name of the corpus in the results, e.g. ascii-100000
+    QString name() const;
+
+    void item(int index, QString& fullPath, QString& shortName) const;
+    // Launch count of item index, most items were never launched
+    int usage(int index) const;
+    CatItem catItem(int index) const;
+
+    // Sequences of search texts typed one key at a time, each sequence
+    // starts from an empty input box
+    QList<QStringList> keystrokes(int count) const;
+
+private:
+    QString directory(int index) const;
+
+private:
+    Script m_script;
+    int m_size;
+    quint32 m_seed;
+};
+
+}
@@ -0,0 +1,138 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchReport.h"
+#include <algorithm>
+#include <cmath>
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QTextStream>
+#include "BenchAlloc.h"
+
+namespace launchy {
+
+BenchSeries::BenchSeries(const QString& benchmark, const QString& corpus)
+    : m_benchmark(benchmark),
+      m_corpus(corpus),
+      m_startAllocations(0),
+      m_startBytes(0),
+      m_ops(0),
+      m_allocations(0),
+      m_bytes(0),
+      m_elapsed(0) {
+
+}
+
+void BenchSeries::start() {
+    m_startAllocations = benchAllocations();
+    m_startBytes = benchAllocatedBytes();
+    m_timer.start();
+}
+
+void BenchSeries::stop(int ops) {
+    qint64 elapsed = m_timer.nsecsElapsed();
+    m_allocations += benchAllocations() - m_startAllocations;
+    m_bytes += benchAllocatedBytes() - m_startBytes;
+    if (ops <= 0) {
+        return;
+    }
+    m_samples.push_back(elapsed / ops);
+    m_weights.push_back(ops);
+    m_ops += ops;
+    m_elapsed += elapsed;
+}
+
+int BenchSeries::count() const {
+    return m_ops;
+}
+
+QJsonObject BenchSeries::result() const {
+    QJsonObject object;
+    object["benchmark"] = m_benchmark;
+    object["corpus"] = m_corpus;
+    object["ops"] = m_ops;
+    object["total_ms"] = m_elapsed / 1e6;
+    object["mean_us"] = m_ops > 0 ? m_elapsed / 1e3 / m_ops : 0.0;
+    object["p50_us"] = percentile(0.50);
+    object["p99_us"] = percentile(0.99);
+    object["max_us"] = percentile(1.0);
+    object["allocations_per_op"] = m_ops > 0 ? (double)m_allocations / m_ops : 0.0;
+    object["bytes_per_op"] = m_ops > 0 ? (double)m_bytes / m_ops : 0.0;
+    return object;
+}
+
+QString BenchSeries::summary() const {
+    return QString("%1 %2: %3 ops, p50 %4 us, p99 %5 us, %6 allocations/op")
+        .arg(m_benchmark, -16)
+        .arg(m_corpus, -13)
+        .arg(m_ops)
+        .arg(percentile(0.50), 0, 'f', 2)
+        .arg(percentile(0.99), 0, 'f', 2)
+        .arg(m_ops > 0 ? (double)m_allocations / m_ops : 0.0, 0, 'f', 1);
+}
+
+// Nearest rank percentile over the operations, a batch counts as ops samples
+double BenchSeries::percentile(double fraction) const {
+    if (m_samples.isEmpty()) {
+        return 0;
+    }
+
+    QVector<int> order(m_samples.size());
+    for (int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(),
+              [this](int a, int b) {
+                  return m_samples.at(a) < m_samples.at(b);
+              });
+
+    qint64 rank = qMax((qint64)1, (qint64)std::ceil(fraction * m_ops));
+    qint64 seen = 0;
+    foreach(int i, order) {
+        seen += m_weights.at(i);
+        if (seen >= rank) {
+            return m_samples.at(i) / 1e3;
+        }
+    }
+    return m_samples.at(order.last()) / 1e3;
+}
+
+BenchReport::BenchReport(QIODevice* device)
+    : m_device(device) {
+
+}
+
+void BenchReport::setContext(const QJsonObject& context) {
+    m_context = context;
+}
+
+void BenchReport::write(const QJsonObject& object) {
+    QJsonObject line = m_context;
+    for (QJsonObject::const_iterator it = object.constBegin(); it != object.constEnd(); ++it) {
+        line.insert(it.key(), it.value());
+    }
+    m_device->write(QJsonDocument(line).toJson(QJsonDocument::Compact));
+    m_device->write("\n");
+}
+
+void BenchReport::write(const BenchSeries& series) {
+    write(series.result());
+    QTextStream(stderr) << series.summary() << endl;
+}
+
+}
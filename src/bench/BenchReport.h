@@ -0,0 +1,82 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+namespace launchy {
+
+// BenchSeries records the latency and the heap allocations of the
+// operations of one benchmark on one corpus
+class BenchSeries {
+public:
+    BenchSeries(const QString& benchmark, const QString& corpus);
+
+    // Time the operations between start and stop, a batch of ops operations
+    // is recorded as ops samples of its average latency
+    void start();
+    void stop(int ops = 1);
+
+    int count() const;
+    // Latency percentiles in microseconds, allocations and bytes per operation
+    QJsonObject result() const;
+    // One line summary for the console
+    QString summary() const;
+
+private:
+    double percentile(double fraction) const;
+
+private:
+    QString m_benchmark;
+    QString m_corpus;
+    QElapsedTimer m_timer;
+    qint64 m_startAllocations;
+    qint64 m_startBytes;
+    // Nanoseconds per operation of each batch and the operations in it
+    QVector<qint64> m_samples;
+    QVector<int> m_weights;
+    int m_ops;
+    qint64 m_allocations;
+    qint64 m_bytes;
+    qint64 m_elapsed;
+};
+
+// BenchReport writes one JSON object per line, so results of different runs
+// can be appended to one file and compared line by line
+class BenchReport {
+public:
+    explicit BenchReport(QIODevice* device);
+
+    // Fields added to every line written afterwards, identifying the run
+    void setContext(const QJsonObject& context);
+    void write(const QJsonObject& object);
+    // Write the result of series and print its summary to the console
+    void write(const BenchSeries& series);
+
+private:
+    QIODevice* m_device;
+    QJsonObject m_context;
+};
+
+}
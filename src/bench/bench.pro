@@ -0,0 +1,50 @@
+TEMPLATE = app
+TARGET = launchy-bench
+CONFIG += console debug_and_release
+CONFIG -= app_bundle
+
+# The catalog sources include Precompiled.h, which needs these modules
+QT += network widgets concurrent
+
+INCLUDEPATH += .. ../lib ../../deps
+
+# The catalog is compiled from the application sources so the benchmark
+# drives exactly the code Launchy runs
+SOURCES = main.cpp \
+    BenchAlloc.cpp \
+    BenchCorpus.cpp \
+    BenchReport.cpp \
+    ../Catalog.cpp \
+    ../CatalogColdSegment.cpp \
+    ../CatalogFile.cpp \
+    ../CatalogStore.cpp \
+    ../FrecencyStore.cpp \
+    ../OptionItem.cpp \
+    ../PathTree.cpp \
+    ../UsageJournal.cpp
+HEADERS = BenchAlloc.h \
+    BenchCorpus.h \
+    BenchReport.h
+
+CONFIG(debug, debug|release):DESTDIR = ../../debug/
+CONFIG(release, debug|release):DESTDIR = ../../release/
+
+OBJECTS_DIR = build
+MOC_DIR = GeneratedFiles
+
+unix:!macx {
+    LIBS += $$DESTDIR/liblaunchy.so
+}
+
+win32 {
+    QT += winextras
+    LIBS += $$DESTDIR/Launchy.lib
+    DEFINES += VC_EXTRALEAN \
+               WIN32 \
+               _UNICODE \
+               UNICODE
+}
+
+macx {
+    LIBS += -L$$DESTDIR -lLaunchy
+}
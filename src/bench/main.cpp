@@ -0,0 +1,316 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QLoggingCategory>
+#include <QScopedPointer>
+#include <QSettings>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include "BenchAlloc.h"
+#include "BenchCorpus.h"
+#include "BenchReport.h"
+#include "Catalog.h"
+#include "LaunchyLib.h"
+#include "OptionItem.h"
+
+using namespace launchy;
+
+// Items generated and added to the catalog at a time
+static const int BUILD_BATCH_SIZE = 1000;
+// Items in every list sorted by the sort benchmark, about what plugins add
+static const int SORT_LIST_SIZE = 1000;
+static const int SORT_LIST_COUNT = 100;
+
+struct BenchOptions {
+    bool fastCatalog;
+    int sequences;
+    int repeat;
+};
+
+static Catalog* createCatalog(const BenchOptions& options) {
+    if (options.fastCatalog) {
+        return new FastCatalog;
+    }
+    return new SlowCatalog;
+}
+
+// Index the corpus as CatalogBuilder does, the CatItem construction is timed separately
+static void benchBuild(const BenchCorpus& corpus, Catalog& catalog, BenchReport& report) {
+    BenchSeries construct("catitem", corpus.name());
+    BenchSeries add("catalog-add", corpus.name());
+    BenchSeries commit("catalog-commit", corpus.name());
+
+    QVector<QString> fullPaths(BUILD_BATCH_SIZE);
+    QVector<QString> shortNames(BUILD_BATCH_SIZE);
+    QVector<CatItem> items(BUILD_BATCH_SIZE);
+    catalog.incrementTimestamp();
+    catalog.beginUpdate();
+    for (int begin = 0; begin < corpus.size(); begin += BUILD_BATCH_SIZE) {
+        int count = qMin(BUILD_BATCH_SIZE, corpus.size() - begin);
+        for (int i = 0; i < count; ++i) {
+            corpus.item(begin + i, fullPaths[i], shortNames[i]);
+        }
+
+        construct.start();
+        for (int i = 0; i < count; ++i) {
+            items[i] = CatItem(fullPaths.at(i), shortNames.at(i));
+        }
+        construct.stop(count);
+
+        for (int i = 0; i < count; ++i) {
+            items[i].usage = corpus.usage(begin + i);
+        }
+        add.start();
+        for (int i = 0; i < count; ++i) {
+            catalog.addItem(items.at(i));
+        }
+        add.stop(count);
+    }
+    commit.start();
+    catalog.commitUpdate();
+    commit.stop();
+
+    report.write(construct);
+    report.write(add);
+    report.write(commit);
+}
+
+static void benchSaveLoad(const BenchCorpus& corpus, Catalog& catalog, const BenchOptions& options,
+                          const QString& filename, BenchReport& report) {
+    BenchSeries save("catalog-save", corpus.name());
+    for (int i = 0; i < options.repeat; ++i) {
+        save.start();
+        bool saved = catalog.save(filename);
+        save.stop();
+        if (!saved) {
+            qWarning() << "benchSaveLoad, Could not save" << filename;
+            return;
+        }
+    }
+    report.write(save);
+
+    BenchSeries load("catalog-load", corpus.name());
+    for (int i = 0; i < options.repeat; ++i) {
+        QScopedPointer<Catalog> loaded(createCatalog(options));
+        load.start();
+        loaded->load(filename);
+        load.stop();
+    }
+    report.write(load);
+}
+
+// Replay the keystroke sequences as the input box does, every key is a search
+// and the search cache lives as long as the text is only extended. The first
+// key searches the whole catalog, the following ones narrow it down
+static void benchSearch(const BenchCorpus& corpus, Catalog& catalog,
+                        const QList<QStringList>& sequences, BenchReport& report) {
+    BenchSeries firstKey("search-first-key", corpus.name());
+    BenchSeries nextKey("search-next-key", corpus.name());
+    QList<CatItem> results;
+    foreach(const QStringList& sequence, sequences) {
+        CatalogSearchCache cache;
+        for (int i = 0; i < sequence.size(); ++i) {
+            BenchSeries& series = i == 0 ? firstKey : nextKey;
+            results.clear();
+            series.start();
+            catalog.searchCatalogs(sequence.at(i), results, &cache);
+            series.stop();
+        }
+    }
+    report.write(firstKey);
+    report.write(nextKey);
+}
+
+// The resident and cold sizes and how many searches the cold segment answered
+static void reportMemory(const BenchCorpus& corpus, const Catalog& catalog, BenchReport& report) {
+    CatalogMemoryStats stats = catalog.memoryStats();
+    QJsonObject memory;
+    memory["benchmark"] = "memory";
+    memory["corpus"] = corpus.name();
+    memory["resident_items"] = stats.residentCount;
+    memory["resident_kib"] = (double)(stats.residentBytes / 1024);
+    memory["cold_items"] = stats.coldCount;
+    memory["cold_kib"] = (double)(stats.coldBytes / 1024);
+    memory["cold_searches"] = stats.coldSearches;
+    memory["cold_hits"] = stats.coldHits;
+    memory["cold_hit_rate"] = stats.coldSearches > 0 ? (double)stats.coldHits / stats.coldSearches : 0.0;
+    report.write(memory);
+    QTextStream(stderr) << QString("%1 %2: %3 resident items %4 KiB, %5 cold items %6 KiB, "
+                                   "cold hits %7 of %8 searches")
+                           .arg("memory", -16)
+                           .arg(corpus.name(), -13)
+                           .arg(stats.residentCount)
+                           .arg(stats.residentBytes / 1024)
+                           .arg(stats.coldCount)
+                           .arg(stats.coldBytes / 1024)
+                           .arg(stats.coldHits)
+                           .arg(stats.coldSearches) << endl;
+}
+
+static void benchSort(const BenchCorpus& corpus, Catalog& catalog,
+                      const QList<QStringList>& sequences, BenchReport& report) {
+    BenchSeries sort("sort", corpus.name());
+    for (int i = 0; i < SORT_LIST_COUNT && i < sequences.size(); ++i) {
+        QList<CatItem> items;
+        items.reserve(SORT_LIST_SIZE);
+        for (int j = 0; j < SORT_LIST_SIZE; ++j) {
+            items.push_back(corpus.catItem((int)(((qint64)i * 7919 + (qint64)j * 104729) % corpus.size())));
+        }
+        sort.start();
+        catalog.sortItems(items, sequences.at(i).last());
+        sort.stop();
+    }
+    report.write(sort);
+}
+
+static void benchCorpus(const BenchCorpus& corpus, const BenchOptions& options,
+                        const QString& workDir, BenchReport& report) {
+    QTextStream(stderr) << "Benchmarking " << corpus.name() << endl;
+    QScopedPointer<Catalog> catalog(createCatalog(options));
+    benchBuild(corpus, *catalog, report);
+
+    QList<QStringList> sequences = corpus.keystrokes(options.sequences);
+    benchSearch(corpus, *catalog, sequences, report);
+    reportMemory(corpus, *catalog, report);
+    benchSort(corpus, *catalog, sequences, report);
+
+    QString filename = QDir(workDir).filePath(corpus.name() + ".db");
+    benchSaveLoad(corpus, *catalog, options, filename, report);
+}
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("launchy-bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the Launchy catalog on synthetic corpora "
+                                     "and writes the results as JSON lines.");
+    parser.addHelpOption();
+    QCommandLineOption sizesOption("sizes", "Comma separated corpus sizes.",
+                                   "sizes", "10000,100000,1000000");
+    QCommandLineOption scriptsOption("scripts", "Comma separated corpus scripts, ascii and cjk.",
+                                     "scripts", "ascii,cjk");
+    QCommandLineOption seedOption("seed", "Seed of the corpora.", "seed", "1");
+    QCommandLineOption sequencesOption("sequences", "Keystroke sequences replayed per corpus.",
+                                       "count", "500");
+    QCommandLineOption repeatOption("repeat", "Catalog saves and loads per corpus.", "count", "5");
+    QCommandLineOption slowOption("slow", "Benchmark SlowCatalog instead of FastCatalog.");
+    QCommandLineOption budgetOption("budget", "Catalog memory budget in KiB, 0 keeps every item "
+                                    "in memory.", "kib", "0");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Append the results to file instead of writing them to stdout.",
+                                    "file");
+    QCommandLineOption verboseOption("verbose", "Show the debug output of the catalog.");
+    parser.addOptions(QList<QCommandLineOption>() << sizesOption << scriptsOption << seedOption
+                      << sequencesOption << repeatOption << slowOption << budgetOption << outputOption
+                      << verboseOption);
+    parser.process(app);
+
+    BenchOptions options;
+    options.fastCatalog = !parser.isSet(slowOption);
+    options.sequences = qMax(1, parser.value(sequencesOption).toInt());
+    options.repeat = qMax(1, parser.value(repeatOption).toInt());
+    quint32 seed = parser.value(seedOption).toUInt();
+
+    QList<int> sizes;
+    foreach(const QString& value, parser.value(sizesOption).split(',', QString::SkipEmptyParts)) {
+        bool ok = false;
+        int size = value.toInt(&ok);
+        if (!ok || size <= 0) {
+            QTextStream(stderr) << "Invalid corpus size " << value << endl;
+            return 1;
+        }
+        sizes.push_back(size);
+    }
+    QList<BenchCorpus::Script> scripts;
+    foreach(const QString& value, parser.value(scriptsOption).split(',', QString::SkipEmptyParts)) {
+        if (value == "ascii") {
+            scripts.push_back(BenchCorpus::Ascii);
+        }
+        else if (value == "cjk") {
+            scripts.push_back(BenchCorpus::Cjk);
+        }
+        else {
+            QTextStream(stderr) << "Invalid corpus script " << value << endl;
+            return 1;
+        }
+    }
+
+    // Every search logs, which would be measured as well
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("default.debug=false");
+    }
+
+    // The catalog reads its options from the global settings, an empty
+    // settings file gives the defaults
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        QTextStream(stderr) << "Could not create a temporary directory" << endl;
+        return 1;
+    }
+    g_settings = QSharedPointer<QSettings>(
+        new QSettings(workDir.filePath("launchy.ini"), QSettings::IniFormat));
+    g_settings->setValue(OPTION_MEMORYBUDGET, qMax(0, parser.value(budgetOption).toInt()));
+
+    QFile output;
+    bool opened = false;
+    if (parser.isSet(outputOption)) {
+        output.setFileName(parser.value(outputOption));
+        opened = output.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+    }
+    else {
+        opened = output.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+    if (!opened) {
+        QTextStream(stderr) << "Could not open the output " << output.errorString() << endl;
+        return 1;
+    }
+
+    BenchReport report(&output);
+    QJsonObject context;
+    context["run"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    context["catalog"] = options.fastCatalog ? "fast" : "slow";
+    context["seed"] = (double)seed;
+    context["budget_kib"] = g_settings->value(OPTION_MEMORYBUDGET).toInt();
+    report.setContext(context);
+
+    QJsonObject environment;
+    environment["benchmark"] = "environment";
+    environment["qt"] = qVersion();
+    environment["os"] = QSysInfo::prettyProductName();
+    environment["cpu"] = QSysInfo::currentCpuArchitecture();
+    environment["threads"] = QThread::idealThreadCount();
+    environment["allocation_source"] = benchAllocationSource();
+    report.write(environment);
+
+    foreach(BenchCorpus::Script script, scripts) {
+        foreach(int size, sizes) {
+            benchCorpus(BenchCorpus(script, size, seed), options, workDir.path(), report);
+            output.flush();
+        }
+    }
+    return 0;
+}
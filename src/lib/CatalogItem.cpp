@@ -19,8 +19,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "CatalogItem.h"
 #include <QDataStream>
-#include <QDebug>
-#include "UnicodeTable.h"
+#include "SearchName.h"
 
 namespace launchy {
 CatItem::CatItem()
@@ -46,8 +45,7 @@ CatItem::CatItem(const QString& full, bool isDir)
         }
     }
 
-    searchName[LOWER] = shortName.toLower();
-    searchName[TRANS] = convertSearchName(searchName[0]);
+    makeSearchNames(shortName, searchName[LOWER], searchName[TRANS]);
 }
 
 CatItem::CatItem(const QString& full, const QString& shortN)
@@ -57,8 +55,7 @@ CatItem::CatItem(const QString& full, const QString& shortN)
       data(NULL),
       pluginId(0) {
 
-    searchName[LOWER] = shortName.toLower();
-    searchName[TRANS] = convertSearchName(searchName[0]);
+    makeSearchNames(shortName, searchName[LOWER], searchName[TRANS]);
 }
 
 CatItem::CatItem(const QString& full, const QString& shortN, uint id)
@@ -68,8 +65,7 @@ CatItem::CatItem(const QString& full, const QString& shortN, uint id)
       data(NULL),
       pluginId(id) {
 
-    searchName[LOWER] = shortName.toLower();
-    searchName[TRANS] = convertSearchName(searchName[0]);
+    makeSearchNames(shortName, searchName[LOWER], searchName[TRANS]);
 }
 
 CatItem::CatItem(const QString& full, const QString& shortN, uint id, const QString& iconPath)
@@ -80,8 +76,7 @@ CatItem::CatItem(const QString& full, const QString& shortN, uint id, const QStr
       data(NULL),
       pluginId(id) {
 
-    searchName[LOWER] = shortName.toLower();
-    searchName[TRANS] = convertSearchName(searchName[0]);
+    makeSearchNames(shortName, searchName[LOWER], searchName[TRANS]);
 }
 
 bool CatItem::operator!=(const CatItem& other) const {
@@ -114,21 +109,4 @@ QDataStream& operator>>(QDataStream& in, CatItem &item) {
     return in;
 }
 
-QString CatItem::convertSearchName(const QString& shortName) {
-    QString result = shortName.toLower();
-
-    for (int i = 0; i<result.size(); ++i) {
-        ushort code = result[i].unicode();
-
-        // zhCN simplified Chinese (pin yin)
-        if (code >= zhCN_min && code <= zhCN_max) {
-            result[i] = zhCN_table[code - zhCN_min];
-        }
-
-    }
-    qDebug() << "CatItem::convertSearchName, shortName:" << shortName
-        << ", result:" << result;
-    return result;
 }
-
-}
\ No newline at end of file
@@ -0,0 +1,105 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SearchName.h"
+#include "UnicodeTable.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LAUNCHY_NAME_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace launchy {
+
+bool isAscii(const QChar* text, int length) {
+    const ushort* units = reinterpret_cast<const ushort*>(text);
+    int pos = 0;
+#ifdef LAUNCHY_NAME_SSE2
+    // Collect the bits of all blocks and test them once at the end
+    __m128i bits = _mm_setzero_si128();
+    for (; pos + 8 <= length; pos += 8) {
+        bits = _mm_or_si128(bits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(units + pos)));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(bits, _mm_set1_epi16((short)0xff80)),
+                                          _mm_setzero_si128())) != 0xffff) {
+        return false;
+    }
+#endif
+    ushort tail = 0;
+    for (; pos < length; ++pos) {
+        tail |= units[pos];
+    }
+    return tail < 0x80;
+}
+
+void asciiToLower(const QChar* text, int length, QChar* dst) {
+    const ushort* units = reinterpret_cast<const ushort*>(text);
+    ushort* out = reinterpret_cast<ushort*>(dst);
+    // Without branches the compiler vectorizes the loop
+    for (int i = 0; i < length; ++i) {
+        ushort c = units[i];
+        out[i] = c + ((ushort)(c - 'A') < 26 ? 'a' - 'A' : 0);
+    }
+}
+
+void asciiToLower(const QChar* text, int length, char* dst) {
+    const ushort* units = reinterpret_cast<const ushort*>(text);
+    for (int i = 0; i < length; ++i) {
+        ushort c = units[i];
+        dst[i] = (char)(c + ((ushort)(c - 'A') < 26 ? 'a' - 'A' : 0));
+    }
+}
+
+bool transliterate(QChar* name, int length) {
+    ushort* units = reinterpret_cast<ushort*>(name);
+    const uint tableSize = zhCN_max - zhCN_min;
+    ushort changed = 0;
+    for (int i = 0; i < length; ++i) {
+        ushort c = units[i];
+        // The index is clamped so the lookup is always valid and the
+        // replacement is a select instead of a branch
+        uint index = (uint)(c - zhCN_min);
+        bool inTable = index < tableSize;
+        ushort mapped = (uchar)zhCN_table[inTable ? index : 0];
+        ushort result = inTable ? mapped : c;
+        changed |= result ^ c;
+        units[i] = result;
+    }
+    return changed != 0;
+}
+
+void makeSearchNames(const QString& shortName, QString& lower, QString& trans) {
+    int length = shortName.size();
+    if (isAscii(shortName.constData(), length)) {
+        lower.resize(length);
+        asciiToLower(shortName.constData(), length, lower.data());
+        trans = lower;
+        return;
+    }
+
+    lower = shortName.toLower();
+    QString converted = lower;
+    if (transliterate(converted.data(), converted.size())) {
+        trans = converted;
+    }
+    else {
+        trans = lower;
+    }
+}
+
+}
@@ -0,0 +1,51 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QString>
+#include "LaunchyLib.h"
+
+namespace launchy {
+
+/**
+    \brief Return true if all the characters of text are ASCII
+    \note Scans 8 code units at a time with SSE2, names are mostly too short for wider blocks
+*/
+LAUNCHY_EXPORT bool isAscii(const QChar* text, int length);
+
+/** Write the lower case form of the ASCII text to dst, which has room for length characters */
+LAUNCHY_EXPORT void asciiToLower(const QChar* text, int length, QChar* dst);
+/** Same as above for a Latin-1 destination */
+LAUNCHY_EXPORT void asciiToLower(const QChar* text, int length, char* dst);
+
+/**
+    \brief Replace the characters of the lower name that have a transliteration in place
+    \return true if any character was replaced
+*/
+LAUNCHY_EXPORT bool transliterate(QChar* name, int length);
+
+/**
+    \brief Derive both search names of a catalog item from its short name
+
+    ASCII names take a fast path without case tables or transliteration.
+    trans shares the data of lower when both are the same.
+*/
+LAUNCHY_EXPORT void makeSearchNames(const QString& shortName, QString& lower, QString& trans);
+
+}
@@ -0,0 +1,242 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SubsequenceMatch.h"
+#include <QtAlgorithms>
+
+// SSE2 is part of every x86-64 processor, AVX2 is detected at runtime
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LAUNCHY_MATCH_SSE2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LAUNCHY_TARGET_AVX2
+#else
+#define LAUNCHY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace launchy {
+
+typedef int (*MatchFunction)(const ushort*, int, const ushort*, int);
+typedef int (*MatchLatin1Function)(const uchar*, int, const ushort*, int);
+
+static int matchScalar(const ushort* text, int textLength,
+                       const ushort* match, int matchLength) {
+    int curChar = 0;
+    for (int i = 0; i < textLength; ++i) {
+        if (text[i] == match[curChar]) {
+            ++curChar;
+            if (curChar >= matchLength) {
+                break;
+            }
+        }
+    }
+    return curChar;
+}
+
+static int matchLatin1Scalar(const uchar* text, int textLength,
+                             const ushort* match, int matchLength) {
+    int curChar = 0;
+    for (int i = 0; i < textLength; ++i) {
+        if (text[i] == match[curChar]) {
+            ++curChar;
+            if (curChar >= matchLength) {
+                break;
+            }
+        }
+    }
+    return curChar;
+}
+
+#ifdef LAUNCHY_MATCH_SSE2
+
+// Each function looks for the next occurrence of the current character of match
+// in blocks of 8 or 16 code units, the scalar loop handles the remaining tail
+
+static int matchSse2(const ushort* text, int textLength,
+                     const ushort* match, int matchLength) {
+    int pos = 0;
+    int curChar = 0;
+    __m128i needle = _mm_set1_epi16((short)match[0]);
+    while (pos + 8 <= textLength) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+        uint mask = (uint)_mm_movemask_epi8(_mm_cmpeq_epi16(block, needle));
+        if (mask == 0) {
+            pos += 8;
+            continue;
+        }
+        // Two mask bits per code unit
+        pos += qCountTrailingZeroBits(mask) / 2 + 1;
+        if (++curChar >= matchLength) {
+            return curChar;
+        }
+        needle = _mm_set1_epi16((short)match[curChar]);
+    }
+    return curChar + matchScalar(text + pos, textLength - pos,
+                                 match + curChar, matchLength - curChar);
+}
+
+LAUNCHY_TARGET_AVX2
+static int matchAvx2(const ushort* text, int textLength,
+                     const ushort* match, int matchLength) {
+    int pos = 0;
+    int curChar = 0;
+    __m256i needle = _mm256_set1_epi16((short)match[0]);
+    while (pos + 16 <= textLength) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+        uint mask = (uint)_mm256_movemask_epi8(_mm256_cmpeq_epi16(block, needle));
+        if (mask == 0) {
+            pos += 16;
+            continue;
+        }
+        pos += qCountTrailingZeroBits(mask) / 2 + 1;
+        if (++curChar >= matchLength) {
+            return curChar;
+        }
+        needle = _mm256_set1_epi16((short)match[curChar]);
+    }
+    // Search names are mostly short, the tail is worth one SSE2 pass
+    return curChar + matchSse2(text + pos, textLength - pos,
+                               match + curChar, matchLength - curChar);
+}
+
+// The Latin-1 versions compare twice as many characters per block,
+// they stop at the first character of match that does not fit in a byte
+
+static int matchLatin1Sse2(const uchar* text, int textLength,
+                           const ushort* match, int matchLength) {
+    int pos = 0;
+    int curChar = 0;
+    if (match[0] > 0xff) {
+        return 0;
+    }
+    __m128i needle = _mm_set1_epi8((char)match[0]);
+    while (pos + 16 <= textLength) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+        uint mask = (uint)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask == 0) {
+            pos += 16;
+            continue;
+        }
+        pos += qCountTrailingZeroBits(mask) + 1;
+        if (++curChar >= matchLength) {
+            return curChar;
+        }
+        if (match[curChar] > 0xff) {
+            return curChar;
+        }
+        needle = _mm_set1_epi8((char)match[curChar]);
+    }
+    return curChar + matchLatin1Scalar(text + pos, textLength - pos,
+                                       match + curChar, matchLength - curChar);
+}
+
+LAUNCHY_TARGET_AVX2
+static int matchLatin1Avx2(const uchar* text, int textLength,
+                           const ushort* match, int matchLength) {
+    int pos = 0;
+    int curChar = 0;
+    if (match[0] > 0xff) {
+        return 0;
+    }
+    __m256i needle = _mm256_set1_epi8((char)match[0]);
+    while (pos + 32 <= textLength) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+        uint mask = (uint)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if (mask == 0) {
+            pos += 32;
+            continue;
+        }
+        pos += qCountTrailingZeroBits(mask) + 1;
+        if (++curChar >= matchLength) {
+            return curChar;
+        }
+        if (match[curChar] > 0xff) {
+            return curChar;
+        }
+        needle = _mm256_set1_epi8((char)match[curChar]);
+    }
+    return curChar + matchLatin1Sse2(text + pos, textLength - pos,
+                                     match + curChar, matchLength - curChar);
+}
+
+static bool hasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // The OS has to save the AVX registers on context switches
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static MatchFunction selectMatchFunction() {
+#ifdef LAUNCHY_MATCH_SSE2
+    return hasAvx2() ? matchAvx2 : matchSse2;
+#else
+    return matchScalar;
+#endif
+}
+
+static MatchLatin1Function selectMatchLatin1Function() {
+#ifdef LAUNCHY_MATCH_SSE2
+    return hasAvx2() ? matchLatin1Avx2 : matchLatin1Sse2;
+#else
+    return matchLatin1Scalar;
+#endif
+}
+
+int subsequenceMatch(const QChar* text, int textLength,
+                     const QChar* match, int matchLength) {
+    if (matchLength <= 0) {
+        return 0;
+    }
+    static const MatchFunction matchFunction = selectMatchFunction();
+    return matchFunction(reinterpret_cast<const ushort*>(text), textLength,
+                         reinterpret_cast<const ushort*>(match), matchLength);
+}
+
+int subsequenceMatch(const char* text, int textLength,
+                     const QChar* match, int matchLength) {
+    if (matchLength <= 0) {
+        return 0;
+    }
+    static const MatchLatin1Function matchFunction = selectMatchLatin1Function();
+    return matchFunction(reinterpret_cast<const uchar*>(text), textLength,
+                         reinterpret_cast<const ushort*>(match), matchLength);
+}
+
+bool isSubsequence(const QString& text, const QString& match) {
+    return subsequenceMatch(text.constData(), text.size(), match.constData(), match.size())
+        == match.size();
+}
+
+}
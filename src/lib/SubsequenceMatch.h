@@ -0,0 +1,52 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QString>
+#include "LaunchyLib.h"
+
+namespace launchy {
+
+/**
+    \brief Match the characters of match in order against text
+
+    Characters are compared as UTF-16 code units without case folding.
+    The search for every character of match continues after the position
+    where the previous one was found.
+    \return The number of leading characters of match that were found,
+    match is a subsequence of text when this equals matchLength
+    \note Uses SSE2 or AVX2 when the processor supports them,
+    the result is the same as the scalar loop
+*/
+LAUNCHY_EXPORT int subsequenceMatch(const QChar* text, int textLength,
+                                    const QChar* match, int matchLength);
+
+/**
+    \brief Match the characters of match in order against Latin-1 text
+
+    Same as the UTF-16 version for text stored one byte per character,
+    characters of match outside Latin-1 are never found.
+*/
+LAUNCHY_EXPORT int subsequenceMatch(const char* text, int textLength,
+                                    const QChar* match, int matchLength);
+
+/** Return true if all the characters of match appear in text in the same order */
+LAUNCHY_EXPORT bool isSubsequence(const QString& text, const QString& match);
+
+}
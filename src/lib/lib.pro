@@ -13,6 +13,8 @@ SOURCES += CatalogItem.cpp \
            LaunchyLib.cpp \
            PluginInterface.cpp \
            PluginInfo.cpp \
+           SearchName.cpp \
+           SubsequenceMatch.cpp \
            UnicodeTable.cpp
 
 HEADERS += CatalogItem.h \
@@ -21,6 +23,8 @@ HEADERS += CatalogItem.h \
            PluginInterface.h \
            PluginMsg.h \
            PluginInfo.h \
+           SearchName.h \
+           SubsequenceMatch.h \
            UnicodeTable.h
 
 DEFINES += LAUNCHY_LIB
@@ -27,6 +27,7 @@
 #include <QFileIconProvider>
 #include "AppBase.h"
 #include "Catalog.h"
+#include "SearchName.h"
 #include "LaunchyWidget.h"
 
 namespace launchy {
@@ -137,30 +138,19 @@ void AppLinux::alterItem(CatItem* item) {
     if (!item->fullPath.endsWith(".desktop", Qt::CaseInsensitive))
         return;
 
-    QString locale = QLocale::system().name();
-
-    QFile file(item->fullPath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    // Entries are parsed once and kept until the file changes
+    QString desktopPath = item->fullPath;
+    DesktopEntry* entry = m_desktopEntries.find(desktopPath);
+    if (!entry)
         return;
 
-    QString name = "";
-    QString icon = "";
-    QString exe = "";
-    while(!file.atEnd()) {
-        QString line = QString::fromUtf8(file.readLine());
-
-        if (line.startsWith("Name[" + locale, Qt::CaseInsensitive))
-            name = line.split("=")[1].trimmed();
-        else if (line.startsWith("Name=", Qt::CaseInsensitive))
-            name = line.split("=")[1].trimmed();
-        else if (line.startsWith("Icon", Qt::CaseInsensitive))
-            icon = line.split("=")[1].trimmed();
-        else if (line.startsWith("Exec", Qt::CaseInsensitive))
-            exe = line.split("=")[1].trimmed();
-    }
+    const QString& name = entry->name;
+    const QString& icon = entry->icon;
+    QString exe = entry->exec;
     if (name.size() >= item->shortName.size() - 8) {
         item->shortName = name;
-        item->searchName = item->shortName.toLower();
+        makeSearchNames(item->shortName, item->searchName[CatItem::LOWER],
+                        item->searchName[CatItem::TRANS]);
     }
 
     // Don't index desktop items wthout icons
@@ -170,56 +160,38 @@ void AppLinux::alterItem(CatItem* item) {
     /* fill in some specifiers while we have the info */
     exe.replace("%i", "--icon " + icon);
     exe.replace("%c", name);
-    exe.replace("%k", item->fullPath);
+    exe.replace("%k", desktopPath);
 
     QStringList allExe = exe.trimmed().split(" ",QString::SkipEmptyParts);
     if (allExe.size() == 0 || allExe[0].size() == 0 )
         return;
     exe = allExe[0];
     allExe.removeFirst();
-    //    exe = exe.trimmed().split(" ")[0];
 
     /* if an absolute or relative path is supplied we can just skip this
        everything else should be checked to avoid picking up [unwanted]
        stuff from the working directory - if it doesnt exsist, use it anyway */
-    if(!exe.contains(QRegExp("^.?.?/"))) {
-        foreach(QString line, QProcess::systemEnvironment()) {
-            if (!line.startsWith("Path", Qt::CaseInsensitive))
-                continue;
-
-            QStringList spl = line.split("=");
-            QStringList spl2 = spl[1].split(":");
-            foreach(QString dir, spl2) {
-                QString tmp = dir + "/" + exe;
-                if (QFile::exists(tmp)) {
-                    exe = tmp;
-                    break;
-                }
-            }
-            break;
-        }
-    }
-
+    if(!exe.contains(QRegExp("^.?.?/")))
+        exe = m_desktopEntries.resolveProgram(exe);
 
     item->fullPath = exe + " " + allExe.join(" ");
 
-    // Cache the icon for this desktop file
-    //shared_ptr<UnixIconProvider> u(dynamic_pointer_cast<UnixIconProvider>(icons));
-//    shared_ptr<UnixIconProvider> u((UnixIconProvider*) icons.get());
-
-    //icon = u->getDesktopIcon(file.fileName(), icon);
-    icon = ((IconProviderLinux*)m_iconProvider)->getDesktopIcon(file.fileName(), icon);
-
-    QFileInfo inf(icon);
-    if (!inf.exists()) {
+    // Look the icon up once for each entry, missing icons included
+    if (!entry->iconResolved) {
+        QString iconPath = ((IconProviderLinux*)m_iconProvider)->getDesktopIcon(desktopPath, icon);
+        entry->iconPath = QFileInfo(iconPath).exists() ? iconPath : QString();
+        entry->iconResolved = true;
+    }
+    if (entry->iconPath.isEmpty()) {
         qDebug() << "couldn't find icon for" << icon << item->fullPath;
         return;
     }
 
-    item->iconPath = icon;
+    item->iconPath = entry->iconPath;
+}
 
-    file.close();
-    return;
+void AppLinux::beginAlterItems() {
+    m_desktopEntries.refresh();
 }
 
 QString AppLinux::expandEnvironmentVars(QString txt) {
@@ -22,6 +22,7 @@
 #include "AppBase.h"
 #include "IconProviderLinux.h"
 #include "Directory.h"
+#include "DesktopEntryCache.h"
 
 namespace launchy {
 
@@ -52,6 +53,10 @@ public:
     */
 
     virtual void alterItem(CatItem* item);
+    virtual void beginAlterItems();
+
+private:
+    DesktopEntryCache m_desktopEntries;
 };
 
 }
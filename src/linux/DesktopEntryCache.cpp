@@ -0,0 +1,268 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Precompiled.h"
+#include "DesktopEntryCache.h"
+#include <climits>
+#include <sys/stat.h>
+#include "DirectoryEnumerator.h"
+
+namespace launchy {
+
+static const char* DESKTOP_ENTRY_GROUP = "[Desktop Entry]";
+
+DesktopEntry::DesktopEntry()
+    : iconResolved(false) {
+
+}
+
+DesktopEntryCache::DesktopEntryCache() {
+
+}
+
+void DesktopEntryCache::refresh() {
+    // The locale of messages as the desktop entry specification describes it,
+    // lang_COUNTRY.ENCODING@MODIFIER
+    QString locale = QString::fromLocal8Bit(qgetenv("LC_ALL"));
+    if (locale.isEmpty()) {
+        locale = QString::fromLocal8Bit(qgetenv("LC_MESSAGES"));
+    }
+    if (locale.isEmpty()) {
+        locale = QString::fromLocal8Bit(qgetenv("LANG"));
+    }
+    if (locale.isEmpty()) {
+        locale = QLocale::system().name();
+    }
+
+    QString modifier;
+    int at = locale.indexOf('@');
+    if (at >= 0) {
+        modifier = locale.mid(at);
+        locale.truncate(at);
+    }
+    int dot = locale.indexOf('.');
+    if (dot >= 0) {
+        locale.truncate(dot);
+    }
+    int underscore = locale.indexOf('_');
+    QString lang = underscore >= 0 ? locale.left(underscore) : locale;
+    QString country = underscore >= 0 ? locale : QString();
+
+    QString locales[4] = {
+        !country.isEmpty() && !modifier.isEmpty() ? country + modifier : QString(),
+        country,
+        !modifier.isEmpty() ? lang + modifier : QString(),
+        lang
+    };
+    bool changed = false;
+    for (int i = 0; i < 4; ++i) {
+        changed = changed || locales[i] != m_locales[i];
+        m_locales[i] = locales[i];
+    }
+    // Names were picked for another locale
+    if (changed) {
+        m_entries.clear();
+    }
+
+    // Watched directories are updated one by one,
+    // the programs are only read again when one may have been installed
+    QStringList path = QString::fromLocal8Bit(qgetenv("PATH")).split(':', QString::SkipEmptyParts);
+    if (!pathChanged(path)) {
+        return;
+    }
+
+    m_programs.clear();
+    m_path = path;
+    m_pathTimes.clear();
+    foreach(const QString& dir, m_path) {
+        qint64 mtime = -1;
+        quint64 inode = 0;
+        DirectoryEnumerator::status(dir, mtime, inode);
+        m_pathTimes.push_back(mtime);
+
+        DirectoryEnumerator entries(dir);
+        while (entries.next()) {
+            QString name = entries.fileName();
+            if (!m_programs.contains(name)) {
+                m_programs.insert(name, dir + "/" + name);
+            }
+        }
+    }
+}
+
+DesktopEntry* DesktopEntryCache::find(const QString& path) {
+    struct stat info;
+    if (stat(QFile::encodeName(path).constData(), &info) != 0) {
+        m_entries.remove(path);
+        return nullptr;
+    }
+    qint64 mtime = (qint64)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+
+    QHash<QString, CachedEntry>::iterator it = m_entries.find(path);
+    if (it != m_entries.end() && it->mtime == mtime && it->size == info.st_size) {
+        return &it->entry;
+    }
+
+    CachedEntry cached;
+    cached.mtime = mtime;
+    cached.size = info.st_size;
+    if (!parse(path, cached.entry)) {
+        m_entries.remove(path);
+        return nullptr;
+    }
+    return &m_entries.insert(path, cached)->entry;
+}
+
+QString DesktopEntryCache::resolveProgram(const QString& name) const {
+    if (!name.contains('/')) {
+        return m_programs.value(name, name);
+    }
+
+    // Names with a directory part are not in the table
+    foreach(const QString& dir, m_path) {
+        QString path = dir + "/" + name;
+        if (QFile::exists(path)) {
+            return path;
+        }
+    }
+    return name;
+}
+
+bool DesktopEntryCache::pathChanged(const QStringList& path) const {
+    if (path != m_path || m_pathTimes.size() != m_path.size()) {
+        return true;
+    }
+    for (int i = 0; i < m_path.size(); ++i) {
+        qint64 mtime = -1;
+        quint64 inode = 0;
+        DirectoryEnumerator::status(m_path.at(i), mtime, inode);
+        if (mtime != m_pathTimes.at(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DesktopEntryCache::parse(const QString& path, DesktopEntry& entry) const {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QString content = QString::fromUtf8(file.readAll());
+    bool inEntry = false;
+    // Rank of the locale of the name found so far, the unlocalized name ranks last
+    int nameRank = INT_MAX;
+    int begin = 0;
+    while (begin < content.size()) {
+        int end = content.indexOf('\n', begin);
+        if (end < 0) {
+            end = content.size();
+        }
+        QStringRef line = content.midRef(begin, end - begin).trimmed();
+        begin = end + 1;
+
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        if (line.startsWith('[')) {
+            // Only the keys of the [Desktop Entry] group describe the application,
+            // the keys of the action groups have the same names
+            if (inEntry) {
+                break;
+            }
+            inEntry = line == QLatin1String(DESKTOP_ENTRY_GROUP);
+            continue;
+        }
+        if (!inEntry) {
+            continue;
+        }
+
+        int equals = line.indexOf('=');
+        if (equals <= 0) {
+            continue;
+        }
+        QStringRef key = line.left(equals).trimmed();
+        QStringRef value = line.mid(equals + 1).trimmed();
+
+        if (key == QLatin1String("Name")) {
+            if (nameRank == INT_MAX) {
+                entry.name = unescape(value.toString());
+                nameRank = INT_MAX - 1;
+            }
+        }
+        else if (key.startsWith(QLatin1String("Name[")) && key.endsWith(']')) {
+            int rank = localeRank(key.mid(5, key.size() - 6).toString());
+            if (rank >= 0 && rank < nameRank) {
+                entry.name = unescape(value.toString());
+                nameRank = rank;
+            }
+        }
+        else if (key == QLatin1String("Icon")) {
+            entry.icon = unescape(value.toString());
+        }
+        else if (key == QLatin1String("Exec")) {
+            entry.exec = value.toString();
+        }
+    }
+    return true;
+}
+
+int DesktopEntryCache::localeRank(const QString& locale) const {
+    for (int i = 0; i < 4; ++i) {
+        if (!m_locales[i].isEmpty() && m_locales[i] == locale) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QString DesktopEntryCache::unescape(const QString& value) {
+    if (!value.contains('\\')) {
+        return value;
+    }
+
+    QString result;
+    result.reserve(value.size());
+    for (int i = 0; i < value.size(); ++i) {
+        QChar c = value.at(i);
+        if (c != '\\' || i + 1 == value.size()) {
+            result += c;
+            continue;
+        }
+        QChar next = value.at(++i);
+        if (next == 's') {
+            result += ' ';
+        }
+        else if (next == 'n') {
+            result += '\n';
+        }
+        else if (next == 't') {
+            result += '\t';
+        }
+        else if (next == 'r') {
+            result += '\r';
+        }
+        else {
+            result += next;
+        }
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,87 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace launchy {
+
+// The keys of the [Desktop Entry] group AppLinux::alterItem uses
+struct DesktopEntry {
+    DesktopEntry();
+
+    // Name in the best matching locale
+    QString name;
+    QString icon;
+    QString exec;
+    // Icon file found for icon, only valid once iconResolved is set
+    QString iconPath;
+    bool iconResolved;
+};
+
+// DesktopEntryCache parses desktop entry files and keeps the result until
+// the modification time or the size of the file changes. It also resolves
+// program names through a table of the files in PATH, which is read once
+// per catalog update instead of probing every directory for every entry.
+// It is not thread safe, only the thread altering the catalog items uses it.
+class DesktopEntryCache {
+public:
+    DesktopEntryCache();
+
+    // Read the locale again and the directories in PATH if PATH or one of
+    // them changed, call it before the items of a catalog update are altered
+    void refresh();
+
+    // Return the entry of the desktop file at path, or nullptr if it can not be read.
+    // The entry stays valid until the next call
+    DesktopEntry* find(const QString& path);
+
+    // Return the path of the program name in PATH, or name if it is not found
+    QString resolveProgram(const QString& name) const;
+
+private:
+    struct CachedEntry {
+        qint64 mtime;
+        qint64 size;
+        DesktopEntry entry;
+    };
+
+    bool parse(const QString& path, DesktopEntry& entry) const;
+    // Return true if PATH names other directories or one of them changed since it was read
+    bool pathChanged(const QStringList& path) const;
+    // Rank of a localized key for the current locale, lower is better, -1 if it does not match
+    int localeRank(const QString& locale) const;
+    static QString unescape(const QString& value);
+
+private:
+    QHash<QString, CachedEntry> m_entries;
+    // Programs in PATH, the first directory containing a name wins
+    QHash<QString, QString> m_programs;
+    QStringList m_path;
+    // Modification times of the directories in m_path when they were read, -1 if missing
+    QVector<qint64> m_pathTimes;
+    // lang_COUNTRY@MODIFIER, lang_COUNTRY, lang@MODIFIER and lang, in that order,
+    // empty where the locale has no such part
+    QString m_locales[4];
+};
+
+}
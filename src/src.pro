@@ -5,7 +5,7 @@ macx:TARGET = Launchy
 CONFIG += debug_and_release
 # CONFIG += qt release
 
-QT += network widgets
+QT += network widgets concurrent
 
 PRECOMPILED_HEADER = Precompiled.h
 CONFIG += precompile_header
@@ -36,7 +36,17 @@ SOURCES = main.cpp \
     Logger.cpp \
     OptionItem.cpp \
     Directory.cpp \
-    UpdateChecker.cpp
+    UpdateChecker.cpp \
+    CatalogFile.cpp \
+    CatalogStore.cpp \
+    FrecencyStore.cpp \
+    UsageJournal.cpp \
+    PathTree.cpp \
+    CatalogColdSegment.cpp \
+    DirectoryIndexer.cpp \
+    DirectoryEnumerator.cpp \
+    DirectoryManifest.cpp \
+    DirectoryWatcher.cpp
 HEADERS = AppBase.h \
     GlobalVar.h \
     LaunchyWidget.h \
@@ -62,7 +72,17 @@ HEADERS = AppBase.h \
     Logger.h \
     OptionItem.h \
     Directory.h \
-    UpdateChecker.h
+    UpdateChecker.h \
+    CatalogFile.h \
+    CatalogStore.h \
+    FrecencyStore.h \
+    UsageJournal.h \
+    PathTree.h \
+    CatalogColdSegment.h \
+    DirectoryIndexer.h \
+    DirectoryEnumerator.h \
+    DirectoryManifest.h \
+    DirectoryWatcher.h
 
 FORMS = OptionDialog.ui
 
@@ -85,8 +105,10 @@ unix:!macx {
     QT += x11extras
     ICON = Launchy.ico
     SOURCES += linux/AppLinux.cpp \
+               linux/DesktopEntryCache.cpp \
                linux/IconProviderLinux.cpp
     HEADERS += linux/AppLinux.h \
+               linux/DesktopEntryCache.h \
                linux/IconProviderLinux.h
     LIBS += -L$$OUT_PWD/src/lib/ $$DESTDIR/liblaunchy.so $$DESTDIR/libpluginpy.so
 
@@ -0,0 +1,65 @@
+/*
+LaunchyQt
+Copyright (C) 2018 Samson Wang
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtTest>
+#include "SearchName.h"
+
+using namespace launchy;
+
+class TestSearchName : public QObject {
+    Q_OBJECT
+private slots:
+    void transliterateTableBounds();
+    void makeSearchNamesAscii();
+};
+
+// The table covers U+4E00 up to and including U+9FA5, the character after
+// it has no transliteration and has to stay as it is
+void TestSearchName::transliterateTableBounds() {
+    QString first(QChar(0x4e00));
+    QVERIFY(transliterate(first.data(), first.size()));
+    QCOMPARE(first, QString("y"));
+
+    QString last(QChar(0x9fa5));
+    QVERIFY(transliterate(last.data(), last.size()));
+    QCOMPARE(last, QString("y"));
+
+    QString after(QChar(0x9fa6));
+    QVERIFY(!transliterate(after.data(), after.size()));
+    QCOMPARE(after, QString(QChar(0x9fa6)));
+
+    QString before(QChar(0x4dff));
+    QVERIFY(!transliterate(before.data(), before.size()));
+    QCOMPARE(before, QString(QChar(0x4dff)));
+}
+
+void TestSearchName::makeSearchNamesAscii() {
+    QString lower;
+    QString trans;
+    makeSearchNames("Launchy Qt", lower, trans);
+    QCOMPARE(lower, QString("launchy qt"));
+    QCOMPARE(trans, QString("launchy qt"));
+
+    makeSearchNames(QString("A") + QChar(0x9fa5), lower, trans);
+    QCOMPARE(lower, QString("a") + QChar(0x9fa5));
+    QCOMPARE(trans, QString("ay"));
+}
+
+QTEST_APPLESS_MAIN(TestSearchName)
+
+#include "TestSearchName.moc"
@@ -0,0 +1,29 @@
+TEMPLATE = app
+TARGET = launchy-tests
+CONFIG += console testcase debug_and_release
+CONFIG -= app_bundle
+
+QT += testlib
+QT -= gui
+
+INCLUDEPATH += ../lib
+
+SOURCES = TestSearchName.cpp
+
+CONFIG(debug, debug|release):DESTDIR = ../../debug/
+CONFIG(release, debug|release):DESTDIR = ../../release/
+
+OBJECTS_DIR = build
+MOC_DIR = GeneratedFiles
+
+unix:!macx {
+    LIBS += $$DESTDIR/liblaunchy.so
+}
+
+win32 {
+    LIBS += $$DESTDIR/Launchy.lib
+}
+
+macx {
+    LIBS += -L$$DESTDIR -lLaunchy
+}